@@ -0,0 +1,230 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "batch.h"
+#include "ta-log.h"
+#include "fileutils.h"
+#include "engine/workPool.h"
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include "utfutils.h"
+#define DIR_SEPARATOR '\\'
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#define DIR_SEPARATOR '/'
+#endif
+
+struct BatchJob {
+  String inPath, outPath;
+  int loops;
+  DivAudioExportModes mode;
+  bool ok;
+  String error;
+  double songTime, renderTime;
+  BatchJob():
+    loops(1),
+    mode(DIV_EXPORT_MODE_ONE),
+    ok(false),
+    songTime(0.0),
+    renderTime(0.0) {}
+};
+
+static bool isModule(const String& name) {
+  size_t dot=name.rfind('.');
+  if (dot==String::npos) return false;
+  String ext=name.substr(dot);
+  std::transform(ext.begin(),ext.end(),ext.begin(),::tolower);
+  return (ext==".fur" || ext==".dmf");
+}
+
+static bool listDir(const String& path, std::vector<String>& files) {
+#ifdef _WIN32
+  WIN32_FIND_DATAW entry;
+  HANDLE dir=FindFirstFileW(utf8To16((path+"\\*").c_str()).c_str(),&entry);
+  if (dir==INVALID_HANDLE_VALUE) return false;
+  do {
+    if (entry.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY) continue;
+    String name=utf16To8(entry.cFileName);
+    if (isModule(name)) files.push_back(path+DIR_SEPARATOR+name);
+  } while (FindNextFileW(dir,&entry));
+  FindClose(dir);
+  return true;
+#else
+  DIR* dir=opendir(path.c_str());
+  if (dir==NULL) return false;
+  struct dirent* entry;
+  while ((entry=readdir(dir))!=NULL) {
+    String name=entry->d_name;
+    String full=path+DIR_SEPARATOR+name;
+    struct stat st;
+    if (stat(full.c_str(),&st)<0) continue;
+    if (!S_ISREG(st.st_mode)) continue;
+    if (isModule(name)) files.push_back(full);
+  }
+  closedir(dir);
+  return true;
+#endif
+}
+
+bool batchCollect(const String& path, std::vector<String>& files) {
+  std::vector<String> found;
+  if (listDir(path,found)) {
+    std::sort(found.begin(),found.end());
+    files.insert(files.end(),found.begin(),found.end());
+    return true;
+  }
+
+  // not a directory. read it as a list
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) {
+    logE("could not open %s! %s\n",path.c_str(),strerror(errno));
+    return false;
+  }
+  char line[4096];
+  while (fgets(line,4095,f)!=NULL) {
+    String name=line;
+    while (!name.empty() && (name.back()=='\n' || name.back()=='\r')) name.pop_back();
+    if (name.empty() || name[0]=='#') continue;
+    files.push_back(name);
+  }
+  fclose(f);
+  return true;
+}
+
+static void renderJob(void* data) {
+  BatchJob* job=(BatchJob*)data;
+  PSMappedFile file;
+  if (!ps_mmap(job->inPath.c_str(),file)) {
+    job->error=strerror(errno);
+    return;
+  }
+  if (file.len<1) {
+    job->error="file is empty";
+    ps_munmap(file);
+    return;
+  }
+
+  // every job has its own engine. they do not share any state.
+  DivEngine* eng=new DivEngine;
+  eng->setNoConfig(true);
+  eng->setAudio(DIV_AUDIO_DUMMY);
+  eng->setView(DIV_STATUS_NOTHING);
+  bool loaded=eng->loadBuffer(file.data,file.len);
+  ps_munmap(file);
+  if (!loaded) {
+    job->error=eng->getLastError();
+    delete eng;
+    return;
+  }
+  if (!eng->init()) {
+    job->error="could not initialize engine";
+    eng->quit();
+    delete eng;
+    return;
+  }
+
+  std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+  eng->saveAudio(job->outPath.c_str(),job->loops,job->mode);
+  eng->waitAudioFile();
+  std::chrono::steady_clock::time_point end=std::chrono::steady_clock::now();
+
+  job->renderTime=std::chrono::duration<double>(end-start).count();
+  job->songTime=(double)eng->getTotalSeconds()+(double)eng->getTotalTicks()/1000000.0;
+  job->ok=true;
+
+  eng->quit();
+  delete eng;
+}
+
+static String outPathFor(const String& inPath, const String& outDir, DivAudioExportModes mode) {
+  String base=inPath;
+  if (!outDir.empty()) {
+    size_t sep=base.find_last_of("/\\");
+    if (sep!=String::npos) base=base.substr(sep+1);
+    base=outDir+DIR_SEPARATOR+base;
+  }
+  // in the other modes this is the prefix of the files
+  if (mode==DIV_EXPORT_MODE_ONE) {
+    base+=".wav";
+  }
+  return base;
+}
+
+int batchRender(const std::vector<String>& files, const String& outDir, int jobs, int loops, DivAudioExportModes mode) {
+  if (files.empty()) {
+    logE("no modules to render!\n");
+    return 1;
+  }
+  if (jobs<1) jobs=1;
+  if (jobs>(int)files.size()) jobs=files.size();
+
+  BatchJob* batch=new BatchJob[files.size()];
+  for (size_t i=0; i<files.size(); i++) {
+    batch[i].inPath=files[i];
+    batch[i].outPath=outPathFor(files[i],outDir,mode);
+    batch[i].loops=loops;
+    batch[i].mode=mode;
+  }
+
+  logI("rendering %d modules using %d threads...\n",(int)files.size(),jobs);
+
+  // the calling thread renders as well
+  DivWorkPool pool;
+  if (jobs>1 && !pool.init(jobs-1)) {
+    logW("could not start worker threads! rendering in one thread.\n");
+  }
+  std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+  for (size_t i=0; i<files.size(); i++) {
+    pool.push(renderJob,&batch[i]);
+  }
+  pool.wait();
+  std::chrono::steady_clock::time_point end=std::chrono::steady_clock::now();
+  pool.quit();
+
+  int failed=0;
+  double totalSong=0.0;
+  double totalRender=0.0;
+  printf("\n%-40s %10s %10s %10s\n","file","length (s)","time (s)","realtime");
+  for (size_t i=0; i<files.size(); i++) {
+    BatchJob& job=batch[i];
+    if (!job.ok) {
+      printf("%-40s FAILED: %s\n",job.inPath.c_str(),job.error.c_str());
+      failed++;
+      continue;
+    }
+    totalSong+=job.songTime;
+    totalRender+=job.renderTime;
+    printf("%-40s %10.2f %10.2f %9.2fx\n",job.inPath.c_str(),job.songTime,job.renderTime,(job.renderTime>0.0)?(job.songTime/job.renderTime):0.0);
+  }
+  double wallTime=std::chrono::duration<double>(end-start).count();
+  printf("\n%d/%d rendered. %.2fs of audio in %.2fs (%.2fx realtime per job, %.2fx overall).\n",
+    (int)files.size()-failed,(int)files.size(),
+    totalSong,wallTime,
+    (totalRender>0.0)?(totalSong/totalRender):0.0,
+    (wallTime>0.0)?(totalSong/wallTime):0.0);
+
+  delete[] batch;
+  return (failed>0)?1:0;
+}
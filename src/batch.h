@@ -0,0 +1,47 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _BATCH_H
+#define _BATCH_H
+#include "ta-utils.h"
+#include "engine/engine.h"
+#include <vector>
+
+/**
+ * collect the modules to render in batch mode.
+ * @param path a directory (every .fur and .dmf file in it is used) or a text file with one module path per line.
+ * @param files the list to append to.
+ * @return whether the path could be read.
+ */
+bool batchCollect(const String& path, std::vector<String>& files);
+
+/**
+ * render a list of modules to audio files, each one in its own engine instance.
+ * neither the config file nor an audio device are used.
+ * @param files the modules to render.
+ * @param outDir the directory to write to, or an empty string to write next to each module.
+ * @param jobs the number of modules to render at once.
+ * @param loops the loop count (see DivEngine::saveAudio).
+ * @param mode the export mode.
+ * @return 0 if every module was rendered, 1 otherwise.
+ */
+int batchRender(const std::vector<String>& files, const String& outDir, int jobs, int loops, DivAudioExportModes mode);
+
+#endif
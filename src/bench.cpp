@@ -0,0 +1,200 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+// furnace-bench: measures the emulation speed of every chip core.
+// every dispatch is driven with the same synthetic command stream on each run,
+// so results can be compared across commits.
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include "ta-log.h"
+#include "engine/engine.h"
+
+#define BENCH_TICK_RATE 60
+
+struct BenchTarget {
+  DivSystem sys;
+  // config key of the core option, or NULL
+  const char* coreKey;
+  int coreCount;
+  const char* coreNames[3];
+};
+
+static const BenchTarget benchTargets[]={
+  {DIV_SYSTEM_YM2612, "ym2612Core", 2, {"Nuked-OPN2", "ymfm", NULL}},
+  {DIV_SYSTEM_YM2612_EXT, "ym2612Core", 2, {"Nuked-OPN2", "ymfm", NULL}},
+  {DIV_SYSTEM_SMS, NULL, 1, {"MAME", NULL, NULL}},
+  {DIV_SYSTEM_GB, NULL, 1, {"SameBoy", NULL, NULL}},
+  {DIV_SYSTEM_PCE, NULL, 1, {"Mednafen", NULL, NULL}},
+  {DIV_SYSTEM_NES, "nesRateShift", 3, {"puNES", "puNES-1/2", "puNES-1/4"}},
+  {DIV_SYSTEM_C64_6581, "c64Core", 3, {"reSID", "reSID-interpolate", "reSID-resample"}},
+  {DIV_SYSTEM_C64_8580, "c64Core", 3, {"reSID", "reSID-interpolate", "reSID-resample"}},
+  {DIV_SYSTEM_YM2151, "arcadeCore", 2, {"ymfm", "Nuked-OPM", NULL}},
+  {DIV_SYSTEM_YM2610, NULL, 1, {"ymfm", NULL, NULL}},
+  {DIV_SYSTEM_YM2610_EXT, NULL, 1, {"ymfm", NULL, NULL}},
+  {DIV_SYSTEM_YM2610_FULL, NULL, 1, {"ymfm", NULL, NULL}},
+  {DIV_SYSTEM_YM2610B, NULL, 1, {"ymfm", NULL, NULL}},
+  {DIV_SYSTEM_YM2610B_EXT, NULL, 1, {"ymfm", NULL, NULL}},
+  {DIV_SYSTEM_AMIGA, NULL, 1, {"internal", NULL, NULL}},
+  {DIV_SYSTEM_AY8910, NULL, 1, {"MAME", NULL, NULL}},
+  {DIV_SYSTEM_AY8930, NULL, 1, {"MAME", NULL, NULL}},
+  {DIV_SYSTEM_TIA, NULL, 1, {"Stella", NULL, NULL}},
+  {DIV_SYSTEM_OPLL, NULL, 1, {"Nuked-OPLL", NULL, NULL}},
+  {DIV_SYSTEM_VRC7, NULL, 1, {"Nuked-OPLL", NULL, NULL}},
+  {DIV_SYSTEM_OPL, NULL, 1, {"Nuked-OPL3", NULL, NULL}},
+  {DIV_SYSTEM_OPL2, NULL, 1, {"Nuked-OPL3", NULL, NULL}},
+  {DIV_SYSTEM_OPL3, NULL, 1, {"Nuked-OPL3", NULL, NULL}},
+  {DIV_SYSTEM_SAA1099, "saaCore", 2, {"MAME", "SAASound", NULL}},
+  {DIV_SYSTEM_PCSPKR, NULL, 1, {"internal", NULL, NULL}},
+  {DIV_SYSTEM_LYNX, NULL, 1, {"Mikey", NULL, NULL}},
+  {DIV_SYSTEM_QSOUND, NULL, 1, {"MAME", NULL, NULL}},
+  {DIV_SYSTEM_SEGAPCM, NULL, 1, {"internal", NULL, NULL}},
+  {DIV_SYSTEM_SWAN, NULL, 1, {"Mednafen", NULL, NULL}},
+};
+
+struct BenchResult {
+  size_t samples;
+  int rate;
+  double wallTime;
+};
+
+// a small LCG. the stream must not depend on the C library.
+static unsigned int benchRand(unsigned int& state) {
+  state=state*1103515245+12345;
+  return (state>>16)&0x7fff;
+}
+
+static bool runBench(DivEngine* eng, DivSystem sys, double seconds, BenchResult& result) {
+  DivDispatchContainer dc;
+  int chans=eng->getChannelCount(sys);
+  dc.init(sys,eng,chans,44100,0);
+  if (dc.dispatch==NULL) return false;
+  DivDispatch* disp=dc.dispatch;
+
+  short* bufL=new short[disp->rate/BENCH_TICK_RATE+1];
+  short* bufR=new short[disp->rate/BENCH_TICK_RATE+1];
+  unsigned int rng=0x46555221;
+  int ticks=seconds*BENCH_TICK_RATE;
+  size_t tickLen=disp->rate/BENCH_TICK_RATE;
+  size_t total=0;
+
+  std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+  for (int i=0; i<ticks; i++) {
+    for (int j=0; j<chans; j++) {
+      // every channel gets an event every 8 ticks, staggered
+      if (((i+j)&7)==0) {
+        unsigned int r=benchRand(rng);
+        if ((r&7)==0) {
+          disp->dispatch(DivCommand(DIV_CMD_NOTE_OFF,j));
+        } else {
+          disp->dispatch(DivCommand(DIV_CMD_VOLUME,j,disp->dispatch(DivCommand(DIV_CMD_GET_VOLMAX,j))-(int)(r&3)));
+          disp->dispatch(DivCommand(DIV_CMD_NOTE_ON,j,36+(int)((r>>3)%48)));
+        }
+      } else if ((i&1)==0) {
+        // vibrato-like pitch changes
+        disp->dispatch(DivCommand(DIV_CMD_PITCH,j,(int)(benchRand(rng)&15)-8));
+      }
+    }
+    disp->tick();
+    disp->acquire(bufL,bufR,0,tickLen);
+    total+=tickLen;
+  }
+  std::chrono::steady_clock::time_point end=std::chrono::steady_clock::now();
+
+  result.samples=total;
+  result.rate=disp->rate;
+  result.wallTime=std::chrono::duration<double>(end-start).count();
+
+  delete[] bufL;
+  delete[] bufR;
+  dc.quit();
+  return true;
+}
+
+int main(int argc, char** argv) {
+  double seconds=10.0;
+  const char* only=NULL;
+  logLevel=LOGLEVEL_WARN;
+
+  for (int i=1; i<argc; i++) {
+    if (strcmp(argv[i],"-seconds")==0 && (i+1)<argc) {
+      seconds=atof(argv[++i]);
+    } else if (strcmp(argv[i],"-system")==0 && (i+1)<argc) {
+      only=argv[++i];
+    } else {
+      printf("usage: %s [-seconds <emulated seconds per chip>] [-system <name filter>]\n",argv[0]);
+      return 1;
+    }
+  }
+  if (seconds<=0.0) seconds=10.0;
+
+  DivEngine* eng=new DivEngine;
+  eng->setNoConfig(true);
+  eng->setAudio(DIV_AUDIO_DUMMY);
+  eng->setView(DIV_STATUS_NOTHING);
+  if (!eng->init()) {
+    logE("could not initialize engine!\n");
+    return 1;
+  }
+
+  // a looped sine wave for the sample-based chips
+  int sampleIndex=eng->addSample();
+  DivSample* sample=eng->getSample(sampleIndex);
+  sample->init(4096);
+  for (int i=0; i<4096; i++) {
+    sample->data16[i]=16384*sin((double)i*M_PI/64.0);
+  }
+  sample->loopStart=0;
+
+  // machine-readable output. one line per chip and core.
+  printf("# furnace-bench " DIV_VERSION "\n");
+  printf("system,core,rate,samples,seconds,samples_per_second,ns_per_sample,realtime\n");
+  int failed=0;
+  for (const BenchTarget& i: benchTargets) {
+    const char* sysName=eng->getSystemName(i.sys);
+    if (only!=NULL && strstr(sysName,only)==NULL) continue;
+    // samples are only rendered to the formats of the chips in the song
+    eng->changeSystem(0,i.sys);
+    for (int j=0; j<i.coreCount; j++) {
+      if (i.coreKey!=NULL) eng->setConf(i.coreKey,j);
+      BenchResult result;
+      if (!runBench(eng,i.sys,seconds,result)) {
+        logE("could not create %s!\n",sysName);
+        failed++;
+        continue;
+      }
+      double wall=(result.wallTime>0.0)?result.wallTime:1e-9;
+      printf("\"%s\",\"%s\",%d,%zu,%f,%.0f,%.2f,%.2f\n",
+        sysName,i.coreNames[j],
+        result.rate,result.samples,result.wallTime,
+        (double)result.samples/wall,
+        (wall*1000000000.0)/(double)result.samples,
+        ((double)result.samples/(double)result.rate)/wall);
+      fflush(stdout);
+    }
+    if (i.coreKey!=NULL) eng->setConf(i.coreKey,0);
+  }
+
+  eng->quit();
+  delete eng;
+  return (failed>0)?1:0;
+}
@@ -176,6 +176,34 @@ class DivDispatch {
      * please honor these variables if needed.
      */
     bool skipRegisterWrites, dumpWrites;
+
+    /**
+     * per-channel output buffers. NULL if not in use.
+     */
+    short** tapL;
+    short** tapR;
+
+    /**
+     * assign a copy of a dispatch made by getState() to this dispatch,
+     * keeping the fields which belong to the engine.
+     * the caller must restore its own chip core pointers afterwards.
+     */
+    template<typename T> void assignState(T* self, const T* state) {
+      DivEngine* keepParent=parent;
+      bool keepSkip=skipRegisterWrites;
+      bool keepDump=dumpWrites;
+      short** keepTapL=tapL;
+      short** keepTapR=tapR;
+      std::vector<DivRegWrite> keepWrites;
+      keepWrites.swap(regWrites);
+      *self=*state;
+      regWrites.swap(keepWrites);
+      parent=keepParent;
+      skipRegisterWrites=keepSkip;
+      dumpWrites=keepDump;
+      tapL=keepTapL;
+      tapR=keepTapR;
+    }
   public:
     /**
      * the rate the samples are provided.
@@ -240,18 +268,36 @@ class DivDispatch {
     virtual int getRegisterPoolDepth();
 
     /**
-     * get this dispatch's state. DO NOT IMPLEMENT YET.
-     * @return a pointer to the dispatch's state. must be deallocated manually!
+     * get this dispatch's state, including the state of its chip core.
+     * @return a pointer to the dispatch's state, or NULL if this dispatch does not support state saves.
+     * must be deallocated using freeState()!
      */
     virtual void* getState();
 
     /**
-     * set this dispatch's state. DO NOT IMPLEMENT YET.
-     * @param state a pointer to a state pertaining to this dispatch,
-     * or NULL if this dispatch does not support state saves.
+     * set this dispatch's state.
+     * mute status is not restored. the caller shall call muteChannel() afterwards.
+     * @param state a pointer to a state previously returned by getState() on this dispatch.
      */
     virtual void setState(void* state);
 
+    /**
+     * deallocate a state returned by getState().
+     * @param state the state.
+     */
+    virtual void freeState(void* state);
+
+    /**
+     * set the per-channel output buffers (taps).
+     * when set, acquire() shall also write the output of each channel to tapL[ch] (and tapR[ch] if stereo),
+     * using the same offsets as bufL/bufR.
+     * @param l the left (or mono) buffers, one per channel, or NULL to disable.
+     * @param r the right buffers.
+     * @param chans the number of buffers in l and r.
+     * @return whether this dispatch supports per-channel output with that many buffers.
+     */
+    virtual bool setChanTaps(short** l, short** r, int chans);
+
     /**
      * mute a channel.
      * @param ch the channel to mute.
@@ -373,6 +419,9 @@ class DivDispatch {
      */
      virtual void quit();
 
+     DivDispatch():
+       tapL(NULL),
+       tapR(NULL) {}
      virtual ~DivDispatch();
 };
 
@@ -50,6 +50,10 @@
 void DivDispatchContainer::setRates(double gotRate) {
   blip_set_rates(bb[0],dispatch->rate,gotRate);
   blip_set_rates(bb[1],dispatch->rate,gotRate);
+  for (int i=0; i<tapChans; i++) {
+    blip_set_rates(tapBB[0][i],dispatch->rate,gotRate);
+    blip_set_rates(tapBB[1][i],dispatch->rate,gotRate);
+  }
 }
 
 void DivDispatchContainer::setQuality(bool lowQual) {
@@ -60,12 +64,30 @@ void DivDispatchContainer::acquire(size_t offset, size_t count) {
   dispatch->acquire(bbIn[0],bbIn[1],offset,count);
 }
 
+void DivDispatchContainer::acquireNext() {
+  acquire(runPos,runNext);
+  runLeft-=runNext;
+  runPos+=runNext;
+  runNext=0;
+}
+
+void DivDispatchContainer::fillNext() {
+  fillBuf(runtotal,lastAvail,bufSize-lastAvail);
+}
+
 void DivDispatchContainer::flush(size_t count) {
   blip_read_samples(bb[0],bbOut[0],count,0);
 
   if (dispatch->isStereo()) {
     blip_read_samples(bb[1],bbOut[1],count,0);
   }
+
+  for (int i=0; i<tapChans; i++) {
+    blip_read_samples(tapBB[0][i],tapOut[0][i],count,0);
+    if (dispatch->isStereo()) {
+      blip_read_samples(tapBB[1][i],tapOut[1][i],count,0);
+    }
+  }
 }
 
 void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size) {
@@ -107,6 +129,87 @@ void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size)
     blip_end_frame(bb[1],runtotal);
     blip_read_samples(bb[1],bbOut[1]+offset,size,0);
   }
+
+  if (tapChans>0) {
+    int sides=dispatch->isStereo()?2:1;
+    for (int i=0; i<sides; i++) {
+      for (int j=0; j<tapChans; j++) {
+        blip_buffer_t* tapBuf=tapBB[i][j];
+        short* in=tapIn[i][j];
+        int prev=tapPrev[i][j];
+        for (size_t k=0; k<runtotal; k++) {
+          blip_add_delta(tapBuf,k,in[k]-prev);
+          prev=in[k];
+        }
+        tapPrev[i][j]=prev;
+        blip_end_frame(tapBuf,runtotal);
+        blip_read_samples(tapBuf,tapOut[i][j]+offset,size,0);
+      }
+    }
+  }
+}
+
+void DivDispatchContainer::resizeIn(size_t len) {
+  delete[] bbIn[0];
+  delete[] bbIn[1];
+  bbIn[0]=new short[len];
+  bbIn[1]=new short[len];
+  for (int i=0; i<tapChans; i++) {
+    delete[] tapIn[0][i];
+    delete[] tapIn[1][i];
+    tapIn[0][i]=new short[len];
+    tapIn[1][i]=new short[len];
+  }
+  bbInLen=len;
+}
+
+bool DivDispatchContainer::enableTaps(int chans, double gotRate) {
+  disableTaps();
+  if (chans<1) return false;
+
+  for (int i=0; i<2; i++) {
+    tapBB[i]=new blip_buffer_t*[chans];
+    tapPrev[i]=new int[chans];
+    tapIn[i]=new short*[chans];
+    tapOut[i]=new short*[chans];
+    for (int j=0; j<chans; j++) {
+      tapBB[i][j]=blip_new(32768);
+      blip_set_rates(tapBB[i][j],dispatch->rate,gotRate);
+      tapPrev[i][j]=0;
+      tapIn[i][j]=new short[bbInLen];
+      tapOut[i][j]=new short[32768];
+      memset(tapIn[i][j],0,bbInLen*sizeof(short));
+      memset(tapOut[i][j],0,32768*sizeof(short));
+    }
+  }
+  tapChans=chans;
+
+  if (!dispatch->setChanTaps(tapIn[0],tapIn[1],chans)) {
+    disableTaps();
+    return false;
+  }
+  return true;
+}
+
+void DivDispatchContainer::disableTaps() {
+  if (tapChans<1) return;
+  dispatch->setChanTaps(NULL,NULL,0);
+  for (int i=0; i<2; i++) {
+    for (int j=0; j<tapChans; j++) {
+      blip_delete(tapBB[i][j]);
+      delete[] tapIn[i][j];
+      delete[] tapOut[i][j];
+    }
+    delete[] tapBB[i];
+    delete[] tapPrev[i];
+    delete[] tapIn[i];
+    delete[] tapOut[i];
+    tapBB[i]=NULL;
+    tapPrev[i]=NULL;
+    tapIn[i]=NULL;
+    tapOut[i]=NULL;
+  }
+  tapChans=0;
 }
 
 void DivDispatchContainer::clear() {
@@ -116,6 +219,12 @@ void DivDispatchContainer::clear() {
   temp[1]=0;
   prevSample[0]=0;
   prevSample[1]=0;
+  for (int i=0; i<tapChans; i++) {
+    blip_clear(tapBB[0][i]);
+    blip_clear(tapBB[1][i]);
+    tapPrev[0][i]=0;
+    tapPrev[1][i]=0;
+  }
   // run for one cycle to determine DC offset
   // TODO: SAA1099 doesn't like that
   /*dispatch->acquire(bbIn[0],bbIn[1],0,1);
@@ -164,17 +273,22 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
     case DIV_SYSTEM_PCE:
       dispatch=new DivPlatformPCE;
       break;
-    case DIV_SYSTEM_NES:
+    case DIV_SYSTEM_NES: {
+      int nesRateShift=eng->getConfInt("nesRateShift",0);
+      if (nesRateShift<0 || nesRateShift>5) nesRateShift=0;
       dispatch=new DivPlatformNES;
+      ((DivPlatformNES*)dispatch)->setRateDivider(1<<nesRateShift);
       break;
+    }
     case DIV_SYSTEM_C64_6581:
+    case DIV_SYSTEM_C64_8580: {
+      int c64Core=eng->getConfInt("c64Core",0);
+      if (c64Core<0 || c64Core>=DIV_C64_CORE_E) c64Core=0;
       dispatch=new DivPlatformC64;
-      ((DivPlatformC64*)dispatch)->setChipModel(true);
-      break;
-    case DIV_SYSTEM_C64_8580:
-      dispatch=new DivPlatformC64;
-      ((DivPlatformC64*)dispatch)->setChipModel(false);
+      ((DivPlatformC64*)dispatch)->setChipModel(sys==DIV_SYSTEM_C64_6581);
+      ((DivPlatformC64*)dispatch)->setCore((DivC64Cores)c64Core);
       break;
+    }
     case DIV_SYSTEM_YM2151:
       dispatch=new DivPlatformArcade;
       ((DivPlatformArcade*)dispatch)->setYMFM(eng->getConfInt("arcadeCore",0)==0);
@@ -269,6 +383,7 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
 
 void DivDispatchContainer::quit() {
   if (dispatch==NULL) return;
+  disableTaps();
   dispatch->quit();
   delete dispatch;
   dispatch=NULL;
@@ -41,7 +41,7 @@
 #include <fmt/printf.h>
 
 void process(void* u, float** in, float** out, int inChans, int outChans, unsigned int size) {
-  ((DivEngine*)u)->nextBuf(in,out,inChans,outChans,size);
+  ((DivEngine*)u)->processAudio(in,out,inChans,outChans,size);
 }
 
 const char* DivEngine::getEffectDesc(unsigned char effect, int chan) {
@@ -129,7 +129,7 @@ void DivEngine::walkSong(int& loopOrder, int& loopRow, int& loopEnd) {
           if (pat[k]->data[j][4+(l<<1)]==0x0d) {
             if (nextOrder==-1 && i<song.ordersLen-1) {
               nextOrder=i+1;
-              nextRow=effectVal;
+              nextRow=(effectVal<song.patLen)?effectVal:0;
             }
           } else if (pat[k]->data[j][4+(l<<1)]==0x0b) {
             if (nextOrder==-1) {
@@ -220,6 +220,7 @@ void DivEngine::runExportThread() {
           disCont[i].setRates(got.rate);
           disCont[i].setQuality(lowQuality);
         }
+        initRenderAhead();
         if (!output->setRun(true)) {
           logE("error while activating audio!\n");
         }
@@ -303,6 +304,7 @@ void DivEngine::runExportThread() {
           disCont[i].setRates(got.rate);
           disCont[i].setQuality(lowQuality);
         }
+        initRenderAhead();
         if (!output->setRun(true)) {
           logE("error while activating audio!\n");
         }
@@ -320,10 +322,18 @@ void DivEngine::runExportThread() {
       outBuf[2]=new float[EXPORT_BUFSIZE*2];
       int loopCount=remainingLoops;
 
+      SNDFILE* sf[DIV_MAX_CHANS];
+      bool chanDone[DIV_MAX_CHANS];
+      bool renderNow[DIV_MAX_CHANS];
+      bool tapped[32];
+      bool picked[32];
+      int sysChans[32];
+      float volL[32];
+      float volR[32];
+
       logI("rendering to files...\n");
-      
+
       for (int i=0; i<chans; i++) {
-        SNDFILE* sf;
         SF_INFO si;
         String fname=fmt::sprintf("%s_c%02d.wav",exportPath,i+1);
         logI("- %s\n",fname.c_str());
@@ -331,43 +341,102 @@ void DivEngine::runExportThread() {
         si.channels=2;
         si.format=SF_FORMAT_WAV|SF_FORMAT_PCM_16;
 
-        sf=sf_open(fname.c_str(),SFM_WRITE,&si);
-        if (sf==NULL) {
+        sf[i]=sf_open(fname.c_str(),SFM_WRITE,&si);
+        if (sf[i]==NULL) {
           logE("could not open file for writing! (%s)\n",sf_strerror(NULL));
-          break;
         }
+        chanDone[i]=(sf[i]==NULL);
+      }
+
+      // systems which provide per-channel output render all of their channels in one pass.
+      // for the rest, every pass renders one channel of each system with the others muted.
+      // channels of different systems do not affect each other, so they can share a pass.
+      memset(sysChans,0,32*sizeof(int));
+      for (int i=0; i<chans; i++) {
+        sysChans[dispatchOfChan[i]]++;
+      }
+      for (int i=0; i<song.systemLen; i++) {
+        tapped[i]=disCont[i].enableTaps(sysChans[i],got.rate);
+        volL[i]=((float)song.systemVol[i]/64.0f)*((float)MIN(127,127-(int)song.systemPan[i])/127.0f)*song.masterVol;
+        volR[i]=((float)song.systemVol[i]/64.0f)*((float)MIN(127,127+(int)song.systemPan[i])/127.0f)*song.masterVol;
+      }
+
+      for (int pass=1; ; pass++) {
+        int pending=0;
+        memset(picked,0,32*sizeof(bool));
+        for (int i=0; i<chans; i++) {
+          int sys=dispatchOfChan[i];
+          renderNow[i]=false;
+          if (chanDone[i]) continue;
+          if (tapped[sys] || !picked[sys]) {
+            renderNow[i]=true;
+            picked[sys]=true;
+            pending++;
+          }
+        }
+        if (pending==0) break;
+        logI("pass %d: %d channels\n",pass,pending);
 
-        for (int j=0; j<chans; j++) {
-          bool mute=(j!=i);
-          isMuted[j]=mute;
-          if (disCont[dispatchOfChan[j]].dispatch!=NULL) {
-            disCont[dispatchOfChan[j]].dispatch->muteChannel(dispatchChanOfChan[j],isMuted[j]);
+        for (int i=0; i<chans; i++) {
+          isMuted[i]=!renderNow[i];
+          if (disCont[dispatchOfChan[i]].dispatch!=NULL) {
+            disCont[dispatchOfChan[i]].dispatch->muteChannel(dispatchChanOfChan[i],isMuted[i]);
           }
         }
-        
+
         curOrder=0;
         remainingLoops=loopCount;
         playSub(false);
 
         while (playing) {
           nextBuf(NULL,outBuf,0,2,EXPORT_BUFSIZE);
-          for (int j=0; j<EXPORT_BUFSIZE; j++) {
-            outBuf[2][j<<1]=MAX(-1.0f,MIN(1.0f,outBuf[0][j]));
-            outBuf[2][1+(j<<1)]=MAX(-1.0f,MIN(1.0f,outBuf[1][j]));
-          }
           if (totalProcessed>EXPORT_BUFSIZE) {
             logE("error: total processed is bigger than export bufsize! %d>%d\n",totalProcessed,EXPORT_BUFSIZE);
           }
-          if (sf_writef_float(sf,outBuf[2],totalProcessed)!=(int)totalProcessed) {
-            logE("error: failed to write entire buffer!\n");
-            break;
+          for (int i=0; i<chans; i++) {
+            if (!renderNow[i]) continue;
+            int sys=dispatchOfChan[i];
+            DivDispatchContainer& dc=disCont[sys];
+            short* srcL;
+            short* srcR;
+            if (tapped[sys]) {
+              srcL=dc.tapOut[0][dispatchChanOfChan[i]];
+              srcR=dc.dispatch->isStereo()?dc.tapOut[1][dispatchChanOfChan[i]]:srcL;
+            } else {
+              srcL=dc.bbOut[0];
+              srcR=dc.dispatch->isStereo()?dc.bbOut[1]:srcL;
+            }
+            for (size_t j=0; j<totalProcessed; j++) {
+              outBuf[2][j<<1]=MAX(-1.0f,MIN(1.0f,((float)srcL[j]/32768.0f)*volL[sys]));
+              outBuf[2][1+(j<<1)]=MAX(-1.0f,MIN(1.0f,((float)srcR[j]/32768.0f)*volR[sys]));
+            }
+            if (sf_writef_float(sf[i],outBuf[2],totalProcessed)!=(int)totalProcessed) {
+              logE("error: failed to write entire buffer! (%d)\n",i);
+            }
+          }
+        }
+
+        for (int i=0; i<chans; i++) {
+          if (renderNow[i]) chanDone[i]=true;
+        }
+        // every tapped channel has been rendered by now
+        for (int i=0; i<song.systemLen; i++) {
+          if (tapped[i]) {
+            disCont[i].disableTaps();
+            tapped[i]=false;
           }
         }
+      }
 
-        if (sf_close(sf)!=0) {
+      for (int i=0; i<chans; i++) {
+        if (sf[i]==NULL) continue;
+        if (sf_close(sf[i])!=0) {
           logE("could not close audio file!\n");
         }
       }
+      for (int i=0; i<song.systemLen; i++) {
+        disCont[i].disableTaps();
+      }
       exporting=false;
 
       delete[] outBuf[0];
@@ -386,6 +455,7 @@ void DivEngine::runExportThread() {
           disCont[i].setRates(got.rate);
           disCont[i].setQuality(lowQuality);
         }
+        initRenderAhead();
         if (!output->setRun(true)) {
           logE("error while activating audio!\n");
         }
@@ -411,6 +481,8 @@ bool DivEngine::saveAudio(const char* path, int loops, DivAudioExportModes mode)
 void DivEngine::waitAudioFile() {
   if (exportThread!=NULL) {
     exportThread->join();
+    delete exportThread;
+    exportThread=NULL;
   }
 }
 
@@ -420,6 +492,7 @@ bool DivEngine::haltAudioFile() {
 }
 
 void DivEngine::notifyInsChange(int ins) {
+  notifySongChange();
   isBusy.lock();
   for (int i=0; i<song.systemLen; i++) {
     disCont[i].dispatch->notifyInsChange(ins);
@@ -427,7 +500,26 @@ void DivEngine::notifyInsChange(int ins) {
   isBusy.unlock();
 }
 
+void DivEngine::expandInsMacros(int ins) {
+  if (ins<0 || ins>=(int)song.ins.size()) return;
+  // running macros look their data up on every tick, so it may move.
+  // only keep it from moving in the middle of one.
+  notifySongChange();
+  isBusy.lock();
+  song.ins[ins]->std.expandMacros();
+  isBusy.unlock();
+}
+
+void DivEngine::shrinkInsMacros(int ins) {
+  if (ins<0 || ins>=(int)song.ins.size()) return;
+  notifySongChange();
+  isBusy.lock();
+  song.ins[ins]->std.shrinkMacros();
+  isBusy.unlock();
+}
+
 void DivEngine::notifyWaveChange(int wave) {
+  notifySongChange();
   isBusy.lock();
   for (int i=0; i<song.systemLen; i++) {
     disCont[i].dispatch->notifyWaveChange(wave);
@@ -435,103 +527,184 @@ void DivEngine::notifyWaveChange(int wave) {
   isBusy.unlock();
 }
 
+void DivEngine::notifySongChange() {
+  checkpointsDirty=true;
+}
+
 void DivEngine::renderSamplesP() {
   isBusy.lock();
   renderSamples();
   isBusy.unlock();
 }
 
+struct DivSampleRenderTask {
+  DivSample* sample;
+  // formats asked for in prepareRender(), then the one for renderFormat()
+  unsigned int formats;
+  unsigned char format;
+  bool success;
+  DivSampleRenderTask(DivSample* s, unsigned int f):
+    sample(s),
+    formats(f),
+    format(0),
+    success(false) {}
+};
+
+static void _prepareSample(void* t) {
+  DivSampleRenderTask* task=(DivSampleRenderTask*)t;
+  task->formats=task->sample->prepareRender(task->formats);
+}
+
+static void _renderSampleFormat(void* t) {
+  DivSampleRenderTask* task=(DivSampleRenderTask*)t;
+  task->success=task->sample->renderFormat(task->format);
+}
+
 void DivEngine::renderSamples() {
+  notifySongChange();
   sPreview.sample=-1;
   sPreview.pos=0;
 
-  // step 1: render samples
-  for (int i=0; i<song.sampleLen; i++) {
-    song.sample[i]->render();
+  // only render the formats used by the chips in the song
+  unsigned int formats=0;
+  // 8-bit PCM is shared by many chips, but only QSound needs its own memory image
+  bool hasQSound=false;
+  for (int i=0; i<song.systemLen; i++) {
+    formats|=getSampleFormats(song.system[i]);
+    if (song.system[i]==DIV_SYSTEM_QSOUND) hasQSound=true;
   }
 
-  // step 2: allocate ADPCM-A samples
-  if (adpcmAMem==NULL) adpcmAMem=new unsigned char[16777216];
-
-  size_t memPos=0;
+  // step 1: render samples
+  // every sample is converted to 16-bit, and then every format of every sample is
+  // encoded as a separate task. each task only writes to its own buffer, so the
+  // result does not depend on the number of threads.
+  std::vector<DivSampleRenderTask> prepTasks;
+  std::vector<DivSampleRenderTask> formatTasks;
+  prepTasks.reserve(song.sampleLen);
   for (int i=0; i<song.sampleLen; i++) {
-    DivSample* s=song.sample[i];
-    int paddedLen=(s->lengthA+255)&(~0xff);
-    if ((memPos&0xf00000)!=((memPos+paddedLen)&0xf00000)) {
-      memPos=(memPos+0xfffff)&0xf00000;
+    // samples which haven't been read yet stay in the file until a chip needs them
+    if (formats==0 && song.sample[i]->lazyData!=NULL) continue;
+    prepTasks.push_back(DivSampleRenderTask(song.sample[i],formats));
+  }
+  if (prepTasks.size()>1) initSamplePool();
+  for (DivSampleRenderTask& i: prepTasks) {
+    if (samplePool!=NULL) {
+      samplePool->push(_prepareSample,&i);
+    } else {
+      _prepareSample(&i);
     }
-    if (memPos>=16777216) {
-      logW("out of ADPCM-A memory for sample %d!\n",i);
-      break;
+  }
+  if (samplePool!=NULL) samplePool->wait();
+
+  for (DivSampleRenderTask& i: prepTasks) {
+    for (unsigned char j=0; j<16; j++) {
+      if (!(i.formats&DIV_SAMPLE_FORMAT(j))) continue;
+      formatTasks.push_back(DivSampleRenderTask(i.sample,0));
+      formatTasks.back().format=j;
     }
-    if (memPos+paddedLen>=16777216) {
-      memcpy(adpcmAMem+memPos,s->dataA,16777216-memPos);
-      logW("out of ADPCM-A memory for sample %d!\n",i);
+  }
+  if (formatTasks.size()>1) initSamplePool();
+  for (DivSampleRenderTask& i: formatTasks) {
+    if (samplePool!=NULL) {
+      samplePool->push(_renderSampleFormat,&i);
     } else {
-      memcpy(adpcmAMem+memPos,s->dataA,paddedLen);
+      _renderSampleFormat(&i);
     }
-    s->offA=memPos;
-    memPos+=paddedLen;
   }
-  adpcmAMemLen=memPos+256;
+  if (samplePool!=NULL) samplePool->wait();
 
-  // step 2: allocate ADPCM-B samples
-  if (adpcmBMem==NULL) adpcmBMem=new unsigned char[16777216];
+  for (DivSampleRenderTask& i: formatTasks) {
+    if (i.success) i.sample->renderedFormats|=DIV_SAMPLE_FORMAT(i.format);
+  }
 
-  memPos=0;
-  for (int i=0; i<song.sampleLen; i++) {
-    DivSample* s=song.sample[i];
-    int paddedLen=(s->lengthB+255)&(~0xff);
-    if ((memPos&0xf00000)!=((memPos+paddedLen)&0xf00000)) {
-      memPos=(memPos+0xfffff)&0xf00000;
-    }
-    if (memPos>=16777216) {
-      logW("out of ADPCM-B memory for sample %d!\n",i);
-      break;
+  // the chip memories are packed incrementally.
+  // a sample is only copied if its data changed or it had to move.
+  // memories of chips which are not in the song are freed.
+
+  // step 2: allocate ADPCM-A samples
+  if (formats&DIV_SAMPLE_FORMAT(5)) {
+    std::vector<DivSampleMemoryEntry> entries;
+    entries.reserve(song.sampleLen);
+    for (int i=0; i<song.sampleLen; i++) {
+      entries.push_back(DivSampleMemoryEntry(i,(song.sample[i]->lengthA+255)&(~0xff)));
     }
-    if (memPos+paddedLen>=16777216) {
-      memcpy(adpcmBMem+memPos,s->dataB,16777216-memPos);
-      logW("out of ADPCM-B memory for sample %d!\n",i);
-    } else {
-      memcpy(adpcmBMem+memPos,s->dataB,paddedLen);
+    adpcmAMem.place(entries);
+    for (DivSampleMemoryEntry& i: entries) {
+      DivSample* s=song.sample[i.index];
+      if (!i.placed) {
+        logW("out of ADPCM-A memory for sample %d!\n",i.index);
+        s->packedA=0;
+        continue;
+      }
+      if (s->offA!=i.offset || s->packedA!=s->renderHash) {
+        if (s->dataA!=NULL) memcpy(adpcmAMem.data+i.offset,s->dataA,i.len);
+        s->offA=i.offset;
+        s->packedA=s->renderHash;
+      }
     }
-    s->offB=memPos;
-    memPos+=paddedLen;
+  } else if (adpcmAMem.data!=NULL) {
+    adpcmAMem.clear();
+    for (int i=0; i<song.sampleLen; i++) song.sample[i]->packedA=0;
   }
-  adpcmBMemLen=memPos+256;
 
-  // step 4: allocate qsound pcm samples
-  if (qsoundMem==NULL) qsoundMem=new unsigned char[16777216];
-  memset(qsoundMem,0,16777216);
-
-  memPos=0;
-  for (int i=0; i<song.sampleLen; i++) {
-    DivSample* s=song.sample[i];
-    int length=s->length8;
-    if (length>65536-16) {
-      length=65536-16;
+  // step 3: allocate ADPCM-B samples
+  if (formats&DIV_SAMPLE_FORMAT(6)) {
+    std::vector<DivSampleMemoryEntry> entries;
+    entries.reserve(song.sampleLen);
+    for (int i=0; i<song.sampleLen; i++) {
+      entries.push_back(DivSampleMemoryEntry(i,(song.sample[i]->lengthB+255)&(~0xff)));
     }
-    if ((memPos&0xff0000)!=((memPos+length)&0xff0000)) {
-      memPos=(memPos+0xffff)&0xff0000;
+    adpcmBMem.place(entries);
+    for (DivSampleMemoryEntry& i: entries) {
+      DivSample* s=song.sample[i.index];
+      if (!i.placed) {
+        logW("out of ADPCM-B memory for sample %d!\n",i.index);
+        s->packedB=0;
+        continue;
+      }
+      if (s->offB!=i.offset || s->packedB!=s->renderHash) {
+        if (s->dataB!=NULL) memcpy(adpcmBMem.data+i.offset,s->dataB,i.len);
+        s->offB=i.offset;
+        s->packedB=s->renderHash;
+      }
     }
-    if (memPos>=16777216) {
-      logW("out of QSound PCM memory for sample %d!\n",i);
-      break;
+  } else if (adpcmBMem.data!=NULL) {
+    adpcmBMem.clear();
+    for (int i=0; i<song.sampleLen; i++) song.sample[i]->packedB=0;
+  }
+
+  // step 4: allocate qsound pcm samples
+  // each sample is followed by 16 bytes of silence, which are looped over when the sample ends.
+  if (hasQSound) {
+    std::vector<DivSampleMemoryEntry> entries;
+    entries.reserve(song.sampleLen);
+    for (int i=0; i<song.sampleLen; i++) {
+      entries.push_back(DivSampleMemoryEntry(i,MIN(song.sample[i]->length8,65536-16)+16));
     }
-    if (memPos+length>=16777216) {
-      for (unsigned int i=0; i<16777216-(memPos+length); i++) {
-        qsoundMem[(memPos+i)^0x8000]=s->data8[i];
+    qsoundMem.place(entries);
+    for (DivSampleMemoryEntry& i: entries) {
+      DivSample* s=song.sample[i.index];
+      if (!i.placed) {
+        logW("out of QSound PCM memory for sample %d!\n",i.index);
+        s->packedQSound=0;
+        continue;
       }
-      logW("out of QSound PCM memory for sample %d!\n",i);
-    } else {
-      for (int i=0; i<length; i++) {
-        qsoundMem[(memPos+i)^0x8000]=s->data8[i];
+      if ((s->offQSound^0x8000)!=i.offset || s->packedQSound!=s->renderHash) {
+        size_t length=i.len-16;
+        for (size_t j=0; j<length; j++) {
+          qsoundMem.data[(i.offset+j)^0x8000]=s->data8[j];
+        }
+        for (size_t j=length; j<i.len; j++) {
+          qsoundMem.data[(i.offset+j)^0x8000]=0;
+        }
+        s->offQSound=i.offset^0x8000;
+        s->packedQSound=s->renderHash;
       }
     }
-    s->offQSound=memPos^0x8000;
-    memPos+=length+16;
+  } else if (qsoundMem.data!=NULL) {
+    qsoundMem.clear();
+    for (int i=0; i<song.sampleLen; i++) song.sample[i]->packedQSound=0;
   }
-  qsoundMemLen=memPos+256;
 }
 
 void DivEngine::createNew(const int* description) {
@@ -727,18 +900,32 @@ void DivEngine::playSub(bool preserveDrift, int goalRow) {
   }
   speedAB=false;
   playing=true;
+  // after a loop the play time no longer matches the song position.
+  checkpointTimeValid=!preserveDrift;
+  DivSeekCheckpoint* cp=loadCheckpoint(goal,preserveDrift);
+  seeking=true;
   for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->setSkipRegisterWrites(true);
   while (playing && curOrder<goal) {
-    if (nextTick(preserveDrift)) return;
+    if (nextTick(preserveDrift)) {
+      seeking=false;
+      return;
+    }
   }
   int oldOrder=curOrder;
   while (playing && curRow<goalRow) {
-    if (nextTick(preserveDrift)) return;
+    if (nextTick(preserveDrift)) {
+      seeking=false;
+      return;
+    }
     if (oldOrder!=curOrder) break;
   }
+  seeking=false;
   for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->setSkipRegisterWrites(false);
   if (goal>0 || goalRow>0) {
-    for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->forceIns();
+    // no need to if the chips are exactly where they should be
+    if (cp==NULL || !cp->exact || cp->order!=goal || goalRow>0) {
+      for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->forceIns();
+    }
   }
   for (int i=0; i<chans; i++) {
     chan[i].cut=-1;
@@ -756,8 +943,126 @@ void DivEngine::playSub(bool preserveDrift, int goalRow) {
   cmdStream.clear();
 }
 
+void DivEngine::saveCheckpoint() {
+  if (checkpointsDirty) clearCheckpoints();
+  DivSeekCheckpoint* old=checkpoints[curOrder];
+  if (old!=NULL && (old->exact || seeking)) return;
+
+  DivSeekCheckpoint* cp=new DivSeekCheckpoint;
+  cp->order=curOrder;
+  cp->systems=0;
+  for (int i=0; i<song.systemLen; i++) {
+    cp->dispatchState[i]=disCont[i].dispatch->getState();
+    if (cp->dispatchState[i]==NULL) {
+      // this system can't save its state. seeking will replay the song instead.
+      freeCheckpoint(cp);
+      return;
+    }
+    cp->systems++;
+  }
+  cp->exact=!seeking;
+  cp->ticks=ticks;
+  cp->nextSpeed=nextSpeed;
+  cp->divider=divider;
+  cp->globalPitch=globalPitch;
+  cp->totalSeconds=totalSeconds;
+  cp->totalTicks=totalTicks;
+  cp->totalTicksR=totalTicksR;
+  cp->speedAB=speedAB;
+  cp->extValuePresent=extValuePresent;
+  cp->extValue=extValue;
+  cp->speed1=speed1;
+  cp->speed2=speed2;
+  cp->chan.assign(chan,chan+chans);
+
+  if (old!=NULL) freeCheckpoint(old);
+  checkpoints[curOrder]=cp;
+}
+
+DivSeekCheckpoint* DivEngine::loadCheckpoint(int goal, bool preserveDrift) {
+  if (checkpointsDirty) clearCheckpoints();
+  if (checkpointsOff) return NULL;
+  DivSeekCheckpoint* cp=NULL;
+  for (int i=MIN(goal,127); i>0; i--) {
+    if (checkpoints[i]!=NULL) {
+      cp=checkpoints[i];
+      break;
+    }
+  }
+  if (cp==NULL) return NULL;
+
+  curOrder=cp->order;
+  curRow=0;
+  ticks=cp->ticks;
+  nextSpeed=cp->nextSpeed;
+  divider=cp->divider;
+  globalPitch=cp->globalPitch;
+  if (!preserveDrift) {
+    totalSeconds=cp->totalSeconds;
+    totalTicks=cp->totalTicks;
+    totalTicksR=cp->totalTicksR;
+  }
+  speedAB=cp->speedAB;
+  extValuePresent=cp->extValuePresent;
+  extValue=cp->extValue;
+  speed1=cp->speed1;
+  speed2=cp->speed2;
+  for (int i=0; i<chans; i++) {
+    chan[i]=cp->chan[i];
+    markTickChan(i);
+  }
+  for (int i=0; i<song.systemLen; i++) {
+    disCont[i].dispatch->setState(cp->dispatchState[i]);
+  }
+  for (int i=0; i<chans; i++) {
+    disCont[dispatchOfChan[i]].dispatch->muteChannel(dispatchChanOfChan[i],isMuted[i]);
+  }
+  return cp;
+}
+
+void DivEngine::freeCheckpoint(DivSeekCheckpoint* cp) {
+  for (int i=0; i<cp->systems; i++) {
+    disCont[i].dispatch->freeState(cp->dispatchState[i]);
+  }
+  delete cp;
+}
+
+void DivEngine::clearCheckpoints() {
+  checkpointsDirty=false;
+  for (int i=0; i<128; i++) {
+    if (checkpoints[i]==NULL) continue;
+    freeCheckpoint(checkpoints[i]);
+    checkpoints[i]=NULL;
+  }
+}
+
+// 2^(i/(12*128)) for one octave of linear pitch.
+// values outside of it are scaled by a power of two, which is exact.
+// the results may differ from pow() by 1 ulp, so a frequency may only
+// change if it was within 1 ulp of an integer.
+struct DivPitchTable {
+  double mult[DIV_PITCH_OCTAVE];
+  DivPitchTable() {
+    for (int i=0; i<DIV_PITCH_OCTAVE; i++) {
+      mult[i]=pow(2.0,(double)i/(double)DIV_PITCH_OCTAVE);
+    }
+  }
+};
+
+static DivPitchTable pitchTable;
+
+double DivEngine::pitchMult(int pitch) {
+  int octave=pitch/DIV_PITCH_OCTAVE;
+  int pos=pitch%DIV_PITCH_OCTAVE;
+  if (pos<0) {
+    pos+=DIV_PITCH_OCTAVE;
+    octave--;
+  }
+  return ldexp(pitchTable.mult[pos],octave);
+}
+
 int DivEngine::calcBaseFreq(double clock, double divider, int note, bool period) {
-  double base=(period?(song.tuning*0.0625):song.tuning)*pow(2.0,(float)(note+3)/12.0);
+  double base=(period?(song.tuning*0.0625):song.tuning)*pitchMult((note+3)*128);
   return period?
          round((clock/base)/divider):
          base*(divider/clock);
@@ -766,8 +1071,8 @@ int DivEngine::calcBaseFreq(double clock, double divider, int note, bool period)
 int DivEngine::calcFreq(int base, int pitch, bool period, int octave) {
   if (song.linearPitch) {
     return period?
-            base*pow(2,-(double)pitch/(12.0*128.0))/(98.0+globalPitch*6.0)*98.0:
-            (base*pow(2,(double)pitch/(12.0*128.0))*(98+globalPitch*6))/98;
+            base*pitchMult(-pitch)/(98.0+globalPitch*6.0)*98.0:
+            (base*pitchMult(pitch)*(98+globalPitch*6))/98;
   }
   return period?
            base-pitch:
@@ -881,6 +1186,7 @@ void DivEngine::recalcChans() {
 void DivEngine::reset() {
   for (int i=0; i<DIV_MAX_CHANS; i++) {
     chan[i]=DivChannelState();
+    markTickChan(i);
     if (i<chans) chan[i].volMax=(disCont[dispatchOfChan[i]].dispatch->dispatch(DivCommand(DIV_CMD_GET_VOLMAX,dispatchChanOfChan[i]))<<8)|0xff;
     chan[i].volume=chan[i].volMax;
   }
@@ -968,6 +1274,8 @@ void DivEngine::previewSample(int sample, int note) {
     isBusy.unlock();
     return;
   }
+  // no chip needed this sample yet, so there is no 16-bit data
+  if (song.sample[sample]->lazyData!=NULL) song.sample[sample]->render(0);
   blip_clear(samp_bb);
   double rate=song.sample[sample]->rate;
   if (note>=0) {
@@ -1420,6 +1728,7 @@ bool DivEngine::addInstrumentFromFile(const char* path) {
           } else { // STD
             if (ins->type!=DIV_INS_GB) {
               ins->std.volMacroLen=reader.readC();
+              ins->std.volMacro.reserve(ins->std.volMacroLen);
               if (version>5) {
                 for (int i=0; i<ins->std.volMacroLen; i++) {
                   ins->std.volMacro[i]=reader.readI();
@@ -1441,6 +1750,7 @@ bool DivEngine::addInstrumentFromFile(const char* path) {
             }
 
             ins->std.arpMacroLen=reader.readC();
+            ins->std.arpMacro.reserve(ins->std.arpMacroLen);
             if (version>5) {
               for (int i=0; i<ins->std.arpMacroLen; i++) {
                 ins->std.arpMacro[i]=reader.readI();
@@ -1461,6 +1771,7 @@ bool DivEngine::addInstrumentFromFile(const char* path) {
             }
 
             ins->std.dutyMacroLen=reader.readC();
+            ins->std.dutyMacro.reserve(ins->std.dutyMacroLen);
             if (version>5) {
               for (int i=0; i<ins->std.dutyMacroLen; i++) {
                 ins->std.dutyMacro[i]=reader.readI();
@@ -1478,6 +1789,7 @@ bool DivEngine::addInstrumentFromFile(const char* path) {
             }
 
             ins->std.waveMacroLen=reader.readC();
+            ins->std.waveMacro.reserve(ins->std.waveMacroLen);
             if (version>5) {
               for (int i=0; i<ins->std.waveMacroLen; i++) {
                 ins->std.waveMacro[i]=reader.readI();
@@ -1634,6 +1946,7 @@ bool DivEngine::addInstrumentFromFile(const char* path) {
 
 void DivEngine::delInstrument(int index) {
   isBusy.lock();
+  notifySongChange();
   if (index>=0 && index<(int)song.ins.size()) {
     for (int i=0; i<song.systemLen; i++) {
       disCont[i].dispatch->notifyInsDeletion(song.ins[index]);
@@ -1643,10 +1956,11 @@ void DivEngine::delInstrument(int index) {
     song.insLen=song.ins.size();
     for (int i=0; i<chans; i++) {
       for (int j=0; j<128; j++) {
-        if (song.pat[i].data[j]==NULL) continue;
+        if (!song.pat[i].hasPattern(j)) continue;
+        DivPattern* pat=song.pat[i].getPattern(j,false);
         for (int k=0; k<song.patLen; k++) {
-          if (song.pat[i].data[j]->data[k][2]>index) {
-            song.pat[i].data[j]->data[k][2]--;
+          if (pat->data[k][2]>index) {
+            pat->data[k][2]--;
           }
         }
       }
@@ -1785,6 +2099,7 @@ bool DivEngine::addWaveFromFile(const char* path) {
 
 void DivEngine::delWave(int index) {
   isBusy.lock();
+  notifySongChange();
   if (index>=0 && index<(int)song.wave.size()) {
     delete song.wave[index];
     song.wave.erase(song.wave.begin()+index);
@@ -1886,6 +2201,7 @@ bool DivEngine::addSampleFromFile(const char* path) {
 
 void DivEngine::delSample(int index) {
   isBusy.lock();
+  notifySongChange();
   if (index>=0 && index<(int)song.sample.size()) {
     delete song.sample[index];
     song.sample.erase(song.sample.begin()+index);
@@ -1899,6 +2215,7 @@ void DivEngine::addOrder(bool duplicate, bool where) {
   unsigned char order[DIV_MAX_CHANS];
   if (song.ordersLen>=0x7e) return;
   isBusy.lock();
+  notifySongChange();
   if (duplicate) {
     for (int i=0; i<DIV_MAX_CHANS; i++) {
       order[i]=song.orders.ord[i][curOrder];
@@ -1945,6 +2262,7 @@ void DivEngine::deepCloneOrder(bool where) {
   if (song.ordersLen>=0x7e) return;
   warnings="";
   isBusy.lock();
+  notifySongChange();
   for (int i=0; i<chans; i++) {
     bool didNotFind=true;
     logD("channel %d\n",i);
@@ -1952,12 +2270,12 @@ void DivEngine::deepCloneOrder(bool where) {
     // find free slot
     for (int j=0; j<128; j++) {
       logD("finding free slot in %d...\n",j);
-      if (song.pat[i].data[j]==NULL) {
+      if (!song.pat[i].hasPattern(j)) {
         int origOrd=order[i];
         order[i]=j;
         DivPattern* oldPat=song.pat[i].getPattern(origOrd,false);
         DivPattern* pat=song.pat[i].getPattern(j,true);
-        memcpy(pat->data,oldPat->data,256*32*sizeof(short));
+        memcpy(pat->data,oldPat->data,MIN(pat->rows,oldPat->rows)*32*sizeof(short));
         logD("found at %d\n",j);
         didNotFind=false;
         break;
@@ -1991,6 +2309,7 @@ void DivEngine::deepCloneOrder(bool where) {
 void DivEngine::deleteOrder() {
   if (song.ordersLen<=1) return;
   isBusy.lock();
+  notifySongChange();
   for (int i=0; i<DIV_MAX_CHANS; i++) {
     for (int j=curOrder; j<song.ordersLen; j++) {
       song.orders.ord[i][j]=song.orders.ord[i][j+1];
@@ -2006,6 +2325,7 @@ void DivEngine::deleteOrder() {
 
 void DivEngine::moveOrderUp() {
   isBusy.lock();
+  notifySongChange();
   if (curOrder<1) {
     isBusy.unlock();
     return;
@@ -2024,6 +2344,7 @@ void DivEngine::moveOrderUp() {
 
 void DivEngine::moveOrderDown() {
   isBusy.lock();
+  notifySongChange();
   if (curOrder>=song.ordersLen-1) {
     isBusy.unlock();
     return;
@@ -2041,14 +2362,16 @@ void DivEngine::moveOrderDown() {
 }
 
 void DivEngine::exchangeIns(int one, int two) {
+  notifySongChange();
   for (int i=0; i<chans; i++) {
     for (int j=0; j<128; j++) {
-      if (song.pat[i].data[j]==NULL) continue;
+      if (!song.pat[i].hasPattern(j)) continue;
+      DivPattern* pat=song.pat[i].getPattern(j,false);
       for (int k=0; k<song.patLen; k++) {
-        if (song.pat[i].data[j]->data[k][2]==one) {
-          song.pat[i].data[j]->data[k][2]=two;
-        } else if (song.pat[i].data[j]->data[k][2]==two) {
-          song.pat[i].data[j]->data[k][2]=one;
+        if (pat->data[k][2]==one) {
+          pat->data[k][2]=two;
+        } else if (pat->data[k][2]==two) {
+          pat->data[k][2]=one;
         }
       }
     }
@@ -2154,6 +2477,7 @@ void DivEngine::setOrder(unsigned char order) {
 void DivEngine::setSysFlags(int system, unsigned int flags, bool restart) {
   isBusy.lock();
   song.systemFlags[system]=flags;
+  notifySongChange();
   disCont[system].dispatch->setFlags(song.systemFlags[system]);
   disCont[system].setRates(got.rate);
   if (restart) {
@@ -2162,11 +2486,18 @@ void DivEngine::setSysFlags(int system, unsigned int flags, bool restart) {
   isBusy.unlock();
 }
 
+void DivEngine::setPatLen(int len) {
+  isBusy.lock();
+  song.setPatLen(len);
+  isBusy.unlock();
+}
+
 void DivEngine::setSongRate(int hz, bool pal) {
   isBusy.lock();
   song.pal=!pal;
   song.hz=hz;
   song.customTempo=(song.hz!=50 && song.hz!=60);
+  notifySongChange();
   divider=60;
   if (song.customTempo) {
     divider=song.hz;
@@ -2201,15 +2532,23 @@ void DivEngine::setConsoleMode(bool enable) {
   consoleMode=enable;
 }
 
+void DivEngine::setNoConfig(bool enable) {
+  noConfig=enable;
+}
+
 bool DivEngine::switchMaster() {
   deinitAudioBackend();
   quitDispatch();
+  quitRenderPool();
+  checkpointInterval=getConfInt("seekCheckpoints",4);
+  initRenderPool();
   initDispatch();
   if (initAudioBackend()) {
     for (int i=0; i<song.systemLen; i++) {
       disCont[i].setRates(got.rate);
       disCont[i].setQuality(lowQuality);
     }
+    initRenderAhead();
     if (!output->setRun(true)) {
       logE("error while activating audio!\n");
       return false;
@@ -2250,8 +2589,49 @@ void DivEngine::initDispatch() {
   isBusy.unlock();
 }
 
+void DivEngine::initRenderPool() {
+  // the thread running nextBuf() takes part in rendering as well
+  int renderThreads=getConfInt("renderThreads",1);
+  if (renderThreads<2) return;
+  renderPool=new DivWorkPool;
+  if (!renderPool->init(renderThreads-1)) {
+    logW("could not start render threads!\n");
+    delete renderPool;
+    renderPool=NULL;
+  }
+}
+
+void DivEngine::quitRenderPool() {
+  if (renderPool==NULL) return;
+  renderPool->quit();
+  delete renderPool;
+  renderPool=NULL;
+}
+
+void DivEngine::initSamplePool() {
+  if (samplePool!=NULL) return;
+  // the thread calling renderSamples() takes part as well
+  int threads=std::thread::hardware_concurrency();
+  if (threads<2) return;
+  samplePool=new DivWorkPool;
+  if (!samplePool->init(threads-1)) {
+    logW("could not start sample render threads!\n");
+    delete samplePool;
+    samplePool=NULL;
+  }
+}
+
+void DivEngine::quitSamplePool() {
+  if (samplePool==NULL) return;
+  samplePool->quit();
+  delete samplePool;
+  samplePool=NULL;
+}
+
 void DivEngine::quitDispatch() {
   isBusy.lock();
+  // states can only be freed by the dispatch which made them.
+  clearCheckpoints();
   for (int i=0; i<song.systemLen; i++) {
     disCont[i].quit();
   }
@@ -2373,48 +2753,99 @@ bool DivEngine::deinitAudioBackend() {
     output->quit();
     delete output;
     output=NULL;
-    audioEngine=DIV_AUDIO_NULL;
+    // the dummy backend stays selected, so export does not open a real audio device afterwards
+    if (audioEngine!=DIV_AUDIO_DUMMY) audioEngine=DIV_AUDIO_NULL;
   }
+  quitRenderAhead();
   return true;
 }
 
+static void _runRenderAhead(DivEngine* caller) {
+  caller->runRenderAhead();
+}
+
+// this must be called after the dispatches have their rates, and right before the audio starts running.
+// the render-ahead thread begins calling nextBuf() immediately.
+bool DivEngine::initRenderAhead() {
+  int renderAhead=getConfInt("renderAhead",0);
+  if (renderAhead<=0 || got.bufsize<1) return false;
+
+  aheadChunk=got.bufsize;
+  if (!aheadRing.init(renderAhead+aheadChunk+1)) {
+    logW("could not allocate render-ahead buffer!\n");
+    return false;
+  }
+  aheadBuf[0]=new float[aheadChunk];
+  aheadBuf[1]=new float[aheadChunk];
+  aheadUnderruns=0;
+  aheadRunning=true;
+  aheadThread=new std::thread(_runRenderAhead,this);
+  logI("rendering %d samples ahead\n",renderAhead);
+  return true;
+}
+
+void DivEngine::quitRenderAhead() {
+  if (aheadThread==NULL) return;
+  aheadLock.lock();
+  aheadRunning=false;
+  aheadLock.unlock();
+  aheadCond.notify_one();
+  aheadThread->join();
+  delete aheadThread;
+  aheadThread=NULL;
+
+  delete[] aheadBuf[0];
+  delete[] aheadBuf[1];
+  aheadBuf[0]=NULL;
+  aheadBuf[1]=NULL;
+  aheadRing.quit();
+  if (aheadUnderruns>0) {
+    logW("render-ahead buffer ran out %d times\n",aheadUnderruns);
+  }
+}
+
 #ifdef _WIN32
 #include "winStuff.h"
 #endif
 
 bool DivEngine::init() {
   // init config
+  if (noConfig) {
+    logD("not using a config file.\n");
+  } else {
 #ifdef _WIN32
-  configPath=getWinConfigPath();
+    configPath=getWinConfigPath();
 #else
-  struct stat st;
-  char* home=getenv("HOME");
-  if (home==NULL) {
-    int uid=getuid();
-    struct passwd* entry=getpwuid(uid);
-    if (entry==NULL) {
-      logW("unable to determine config directory! (%s)\n",strerror(errno));
-      configPath=".";
+    struct stat st;
+    char* home=getenv("HOME");
+    if (home==NULL) {
+      int uid=getuid();
+      struct passwd* entry=getpwuid(uid);
+      if (entry==NULL) {
+        logW("unable to determine config directory! (%s)\n",strerror(errno));
+        configPath=".";
+      } else {
+        configPath=entry->pw_dir;
+#ifdef __APPLE__
+        CHECK_CONFIG_DIR_MAC();
+#else
+        CHECK_CONFIG_DIR();
+#endif
+      }
     } else {
-      configPath=entry->pw_dir;
+      configPath=home;
 #ifdef __APPLE__
       CHECK_CONFIG_DIR_MAC();
 #else
       CHECK_CONFIG_DIR();
 #endif
     }
-  } else {
-    configPath=home;
-#ifdef __APPLE__
-    CHECK_CONFIG_DIR_MAC();
-#else
-    CHECK_CONFIG_DIR();
 #endif
-  }
-#endif
-  logD("config path: %s\n",configPath.c_str());
+    logD("config path: %s\n",configPath.c_str());
 
-  loadConf();
+    loadConf();
+  }
+  checkpointInterval=getConfInt("seekCheckpoints",4);
 
   // init the rest of engine
   bool haveAudio=false;
@@ -2449,6 +2880,7 @@ bool DivEngine::init() {
   oscBuf[0]=new float[32768];
   oscBuf[1]=new float[32768];
 
+  initRenderPool();
   initDispatch();
   reset();
   active=true;
@@ -2456,6 +2888,7 @@ bool DivEngine::init() {
   if (!haveAudio) {
     return false;
   } else {
+    initRenderAhead();
     if (!output->setRun(true)) {
       logE("error while activating!\n");
       return false;
@@ -2467,10 +2900,27 @@ bool DivEngine::init() {
 bool DivEngine::quit() {
   deinitAudioBackend();
   quitDispatch();
-  logI("saving config.\n");
-  saveConf();
+  quitRenderPool();
+  quitSamplePool();
+  if (!noConfig) {
+    logI("saving config.\n");
+    saveConf();
+  }
   active=false;
   delete[] oscBuf[0];
   delete[] oscBuf[1];
+  if (samp_bb!=NULL) {
+    blip_delete(samp_bb);
+    samp_bb=NULL;
+  }
+  delete[] samp_bbIn;
+  delete[] samp_bbOut;
+  samp_bbIn=NULL;
+  samp_bbOut=NULL;
+  if (metroTick!=NULL) {
+    delete[] metroTick;
+    metroTick=NULL;
+    metroTickLen=0;
+  }
   return true;
 }
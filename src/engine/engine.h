@@ -23,10 +23,15 @@
 #include "dispatch.h"
 #include "dataErrors.h"
 #include "safeWriter.h"
+#include "workPool.h"
+#include "sampleMemory.h"
+#include "ringBuffer.h"
 #include "../audio/taAudio.h"
 #include "blip_buf.h"
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <map>
 #include <queue>
 
@@ -40,6 +45,9 @@
 #define DIV_VERSION "dev63"
 #define DIV_ENGINE_VERSION 63
 
+// linear pitch steps per octave
+#define DIV_PITCH_OCTAVE (12*128)
+
 enum DivStatusView {
   DIV_STATUS_NOTHING=0,
   DIV_STATUS_PATTERN,
@@ -68,7 +76,6 @@ enum DivHaltPositions {
 };
 
 struct DivChannelState {
-  std::vector<DivDelayedCommand> delayed;
   int note, oldNote, pitch, portaSpeed, portaNote;
   int volume, volSpeed, cut, rowDelay, volMax;
   int delayOrder, delayRow, retrigSpeed, retrigTick;
@@ -138,11 +145,26 @@ struct DivDispatchContainer {
   short* bbOut[2];
   bool lowQuality;
 
+  // per-buffer render state (see DivEngine::nextBuf)
+  size_t runtotal, runLeft, runPos, runNext, lastAvail, bufSize;
+
+  // per-channel output, if enabled (see DivDispatch::setChanTaps)
+  int tapChans;
+  blip_buffer_t** tapBB[2];
+  int* tapPrev[2];
+  short** tapIn[2];
+  short** tapOut[2];
+
   void setRates(double gotRate);
   void setQuality(bool lowQual);
   void acquire(size_t offset, size_t count);
+  void acquireNext();
+  void fillNext();
   void flush(size_t count);
   void fillBuf(size_t runtotal, size_t offset, size_t size);
+  void resizeIn(size_t len);
+  bool enableTaps(int chans, double gotRate);
+  void disableTaps();
   void clear();
   void init(DivSystem sys, DivEngine* eng, int chanCount, double gotRate, unsigned int flags);
   void quit();
@@ -154,12 +176,53 @@ struct DivDispatchContainer {
     prevSample{0,0},
     bbIn{NULL,NULL},
     bbOut{NULL,NULL},
-    lowQuality(false) {}
+    lowQuality(false),
+    runtotal(0),
+    runLeft(0),
+    runPos(0),
+    runNext(0),
+    lastAvail(0),
+    bufSize(0),
+    tapChans(0),
+    tapBB{NULL,NULL},
+    tapPrev{NULL,NULL},
+    tapIn{NULL,NULL},
+    tapOut{NULL,NULL} {}
+};
+
+// a copy of the playback state taken at the first row of an order.
+// playSub() starts from the closest one instead of replaying the song from the beginning.
+struct DivSeekCheckpoint {
+  int order, systems;
+  // false if taken while seeking (chips were not running, so forceIns() is needed after loading).
+  bool exact;
+  int ticks, nextSpeed, divider, globalPitch;
+  int totalSeconds, totalTicks, totalTicksR;
+  bool speedAB, extValuePresent;
+  unsigned char extValue, speed1, speed2;
+  std::vector<DivChannelState> chan;
+  void* dispatchState[32];
 };
 
 class DivEngine {
   DivDispatchContainer disCont[32];
   TAAudio* output;
+  DivWorkPool* renderPool;
+  DivWorkPool* samplePool;
+  DivAudioRing aheadRing;
+  std::thread* aheadThread;
+  std::mutex aheadLock;
+  std::condition_variable aheadCond;
+  float* aheadBuf[2];
+  size_t aheadChunk;
+  bool aheadRunning;
+  unsigned int aheadUnderruns;
+  DivSeekCheckpoint* checkpoints[128];
+  int checkpointInterval;
+  bool checkpointTimeValid;
+  bool seeking;
+  bool checkpointsOff;
+  std::atomic<bool> checkpointsDirty;
   TAAudioDesc want, got;
   String exportPath;
   std::thread* exportThread;
@@ -171,6 +234,7 @@ class DivEngine {
   bool speedAB;
   bool endOfSong;
   bool consoleMode;
+  bool noConfig;
   bool extValuePresent;
   bool repeatPattern;
   bool metronome;
@@ -186,6 +250,9 @@ class DivEngine {
   DivStatusView view;
   DivHaltPositions haltOn;
   DivChannelState chan[DIV_MAX_CHANS];
+  // channels which may have effects to run on every tick.
+  // processRow() adds a channel and nextTick() removes it once it is idle.
+  unsigned int tickChans[DIV_MAX_CHANS>>5];
   DivAudioEngines audioEngine;
   DivAudioExportModes exportMode;
   std::map<String,String> conf;
@@ -226,7 +293,11 @@ class DivEngine {
   DivSystem systemFromFile(unsigned char val);
   unsigned char systemToFile(DivSystem val);
   int dispatchCmd(DivCommand c);
+  void markTickChan(int ch);
+  int nextTickChan(int ch);
   void processRow(int i, bool afterDelay);
+  void acquireSystems();
+  void fillSystems();
   void nextOrder();
   void nextRow();
   void performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write, int streamOff, double* loopTimer, double* loopFreq, int* loopSample, bool isSecond);
@@ -239,12 +310,27 @@ class DivEngine {
   void reset();
   void playSub(bool preserveDrift, int goalRow=0);
 
-  bool loadDMF(unsigned char* file, size_t len);
-  bool loadFur(unsigned char* file, size_t len);
+  void saveCheckpoint();
+  DivSeekCheckpoint* loadCheckpoint(int goal, bool preserveDrift);
+  void freeCheckpoint(DivSeekCheckpoint* cp);
+  void clearCheckpoints();
+
+  bool loadDMF(const unsigned char* file, size_t len);
+  // in lazy mode, a non-NULL owned buffer (allocated with new[] and holding the file) is taken over by the song.
+  bool loadFur(const unsigned char* file, size_t len, bool lazy, unsigned char*& owned);
 
   bool initAudioBackend();
   bool deinitAudioBackend();
 
+  void initRenderPool();
+  void quitRenderPool();
+
+  void initSamplePool();
+  void quitSamplePool();
+
+  bool initRenderAhead();
+  void quitRenderAhead();
+
   void exchangeIns(int one, int two);
 
   public:
@@ -257,14 +343,20 @@ class DivEngine {
     float oscSize;
 
     void runExportThread();
+    void runRenderAhead();
     void nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size);
+    // audio callback. reads from the render-ahead buffer if enabled.
+    void processAudio(float** in, float** out, int inChans, int outChans, unsigned int size);
     DivInstrument* getIns(int index);
     DivWavetable* getWave(int index);
     DivSample* getSample(int index);
     // start fresh
     void createNew(const int* description);
-    // load a file.
+    // load a file. takes ownership of f.
     bool load(unsigned char* f, size_t length);
+    // load a file from memory which is not freed (e.g. a mapped file).
+    // if lazy is true, patterns and samples are only read when they are used.
+    bool loadBuffer(const unsigned char* f, size_t length, bool lazy=false);
     // save as .dmf.
     SafeWriter* saveDMF(unsigned char version);
     // save as .fur.
@@ -284,6 +376,12 @@ class DivEngine {
     void notifyInsChange(int ins);
     // notify wavetable change
     void notifyWaveChange(int wave);
+    // grow an instrument's macros to full length before editing them
+    void expandInsMacros(int ins);
+    // shrink an instrument's macros back to their length after editing them
+    void shrinkInsMacros(int ins);
+    // notify song data change (drops seek checkpoints)
+    void notifySongChange();
 
     // returns whether a system is VGM compatible
     bool isVGMExportable(DivSystem which);
@@ -308,6 +406,9 @@ class DivEngine {
     void setConf(String key, double value);
     void setConf(String key, String value);
 
+    // get 2^(pitch/(12*128)), where pitch is in 1/128ths of a semitone
+    double pitchMult(int pitch);
+
     // calculate base frequency/period
     int calcBaseFreq(double clock, double divider, int note, bool period);
 
@@ -389,6 +490,9 @@ class DivEngine {
     // is STD system
     bool isSTDSystem(DivSystem sys);
 
+    // get the sample formats a system plays from (DIV_SAMPLE_FORMAT mask, 16-bit is implied)
+    unsigned int getSampleFormats(DivSystem sys);
+
     // is channel muted
     bool isChannelMuted(int chan);
 
@@ -523,6 +627,9 @@ class DivEngine {
     // set Hz
     void setSongRate(int hz, bool pal);
 
+    // set pattern length
+    void setPatLen(int len);
+
     // set remaining loops. -1 means loop forever.
     void setLoops(int loops);
 
@@ -555,6 +662,9 @@ class DivEngine {
 
     // set the console mode.
     void setConsoleMode(bool enable);
+
+    // don't load or save the config file (defaults are used). call before init().
+    void setNoConfig(bool enable);
     
     // get metronome
     bool getMetronome();
@@ -622,12 +732,9 @@ class DivEngine {
     // terminate the engine.
     bool quit();
 
-    unsigned char* adpcmAMem;
-    size_t adpcmAMemLen;
-    unsigned char* adpcmBMem;
-    size_t adpcmBMemLen;
-    unsigned char* qsoundMem;
-    size_t qsoundMemLen;
+    DivSampleMemory adpcmAMem;
+    DivSampleMemory adpcmBMem;
+    DivSampleMemory qsoundMem;
     unsigned char* qsoundAMem;
     size_t qsoundAMemLen;
     unsigned char* dpcmMem;
@@ -635,6 +742,19 @@ class DivEngine {
 
     DivEngine():
       output(NULL),
+      renderPool(NULL),
+      samplePool(NULL),
+      aheadThread(NULL),
+      aheadBuf{NULL,NULL},
+      aheadChunk(0),
+      aheadRunning(false),
+      aheadUnderruns(0),
+      checkpoints(),
+      checkpointInterval(4),
+      checkpointTimeValid(false),
+      seeking(false),
+      checkpointsOff(false),
+      checkpointsDirty(false),
       exportThread(NULL),
       chans(0),
       active(false),
@@ -644,6 +764,7 @@ class DivEngine {
       speedAB(false),
       endOfSong(false),
       consoleMode(false),
+      noConfig(false),
       extValuePresent(false),
       repeatPattern(false),
       metronome(false),
@@ -674,9 +795,12 @@ class DivEngine {
       view(DIV_STATUS_NOTHING),
       haltOn(DIV_HALT_NONE),
       audioEngine(DIV_AUDIO_NULL),
+      samp_bb(NULL),
       samp_bbInLen(0),
       samp_temp(0),
       samp_prevSample(0),
+      samp_bbIn(NULL),
+      samp_bbOut(NULL),
       metroTick(NULL),
       metroTickLen(0),
       metroFreq(0),
@@ -685,15 +809,14 @@ class DivEngine {
       totalProcessed(0),
       oscBuf{NULL,NULL},
       oscSize(1),
-      adpcmAMem(NULL),
-      adpcmAMemLen(0),
-      adpcmBMem(NULL),
-      adpcmBMemLen(0),
-      qsoundMem(NULL),
-      qsoundMemLen(0),
+      adpcmAMem(16777216,1048576,256,256,256),
+      adpcmBMem(16777216,1048576,256,256,256),
+      qsoundMem(16777216,65536,1,256,65536),
       qsoundAMem(NULL),
       qsoundAMemLen(0),
       dpcmMem(NULL),
-      dpcmMemLen(0) {}
+      dpcmMemLen(0) {
+      memset(tickChans,0,sizeof(tickChans));
+    }
 };
 #endif
@@ -27,29 +27,14 @@
 #define DIV_DMF_MAGIC ".DelekDefleMask."
 #define DIV_FUR_MAGIC "-Furnace module-"
 
-struct InflateBlock {
-  unsigned char* buf;
-  size_t len;
-  size_t blockSize;
-  InflateBlock(size_t s) {
-    buf=new unsigned char[s];
-    len=s;
-    blockSize=0;
-  }
-  ~InflateBlock() {
-    delete[] buf;
-    len=0;
-  }
-};
-
 static double samplePitches[11]={
   0.1666666666, 0.2, 0.25, 0.333333333, 0.5,
   1,
   2, 3, 4, 5, 6
 };
 
-bool DivEngine::loadDMF(unsigned char* file, size_t len) {
-  SafeReader reader=SafeReader(file,len);
+bool DivEngine::loadDMF(const unsigned char* file, size_t len) {
+  SafeReader reader=SafeReader((void*)file,len);
   warnings="";
   try {
     DivSong ds;
@@ -64,7 +49,6 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
     if (!reader.seek(16,SEEK_SET)) {
       logE("premature end of file!\n");
       lastError="incomplete file";
-      delete[] file;
       return false;
     }
     ds.version=(unsigned char)reader.readC();
@@ -72,7 +56,6 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
     if (ds.version>0x19) {
       logE("this version is not supported by Furnace yet!\n");
       lastError="this version is not supported by Furnace yet";
-      delete[] file;
       return false;
     }
     unsigned char sys=0;
@@ -88,7 +71,6 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
     if (ds.system[0]==DIV_SYSTEM_NULL) {
       logE("invalid system 0x%.2x!",sys);
       lastError="system not supported. running old version?";
-      delete[] file;
       return false;
     }
     
@@ -186,6 +168,12 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
     } else {
       ds.patLen=(unsigned char)reader.readC();
     }
+    if (ds.patLen<0 || ds.patLen>256) {
+      logE("invalid pattern length %d!\n",ds.patLen);
+      lastError="file is corrupt or unreadable at pattern length";
+      return false;
+    }
+    ds.setPatLen(ds.patLen);
     ds.ordersLen=(unsigned char)reader.readC();
 
     if (ds.version<20 && ds.version>3) {
@@ -295,7 +283,6 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
         if (ins->fm.ops!=2 && ins->fm.ops!=4) {
           logE("invalid op count %d. did we read it wrong?\n",ins->fm.ops);
           lastError="file is corrupt or unreadable at operators";
-          delete[] file;
           return false;
         }
         ins->fm.ams=reader.readC();
@@ -380,6 +367,7 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
       } else { // STD
         if (ds.system[0]!=DIV_SYSTEM_GB || ds.version<0x12) {
           ins->std.volMacroLen=reader.readC();
+          ins->std.volMacro.reserve(ins->std.volMacroLen);
           for (int j=0; j<ins->std.volMacroLen; j++) {
             if (ds.version<0x0e) {
               ins->std.volMacro[j]=reader.readC();
@@ -396,6 +384,7 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
         }
 
         ins->std.arpMacroLen=reader.readC();
+        ins->std.arpMacro.reserve(ins->std.arpMacroLen);
         for (int j=0; j<ins->std.arpMacroLen; j++) {
           if (ds.version<0x0e) {
             ins->std.arpMacro[j]=reader.readC();
@@ -419,6 +408,7 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
         }
 
         ins->std.dutyMacroLen=reader.readC();
+        ins->std.dutyMacro.reserve(ins->std.dutyMacroLen);
         for (int j=0; j<ins->std.dutyMacroLen; j++) {
           if (ds.version<0x0e) {
             ins->std.dutyMacro[j]=reader.readC();
@@ -437,6 +427,7 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
         }
 
         ins->std.waveMacroLen=reader.readC();
+        ins->std.waveMacro.reserve(ins->std.waveMacroLen);
         for (int j=0; j<ins->std.waveMacroLen; j++) {
           if (ds.version<0x0e) {
             ins->std.waveMacro[j]=reader.readC();
@@ -520,7 +511,6 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
         if (wave->len>33) {
           logE("invalid wave length %d. are we doing something wrong?\n",wave->len);
           lastError="file is corrupt or unreadable at wavetables";
-          delete[] file;
           return false;
         }
         logD("%d length %d\n",i,wave->len);
@@ -547,7 +537,6 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
       if (chan.effectRows>4 || chan.effectRows<1) {
         logE("invalid effect row count %d. are you sure everything is ok?\n",chan.effectRows);
         lastError="file is corrupt or unreadable at effect rows";
-        delete[] file;
         return false;
       }
       for (int j=0; j<ds.ordersLen; j++) {
@@ -622,7 +611,6 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
       if (length<0) {
         logE("invalid sample length %d. are we doing something wrong?\n",length);
         lastError="file is corrupt or unreadable at samples";
-        delete[] file;
         return false;
       }
       if (ds.version>0x16) {
@@ -734,21 +722,260 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
   } catch (EndOfFileException e) {
     logE("premature end of file!\n");
     lastError="incomplete file";
-    delete[] file;
     return false;
   }
-  delete[] file;
   return true;
 }
 
-bool DivEngine::loadFur(unsigned char* file, size_t len) {
+// an instrument, wavetable, sample or pattern of a .fur file.
+// each one is read by its own task with its own reader.
+enum DivFurReadType {
+  DIV_FUR_READ_INS=0,
+  DIV_FUR_READ_WAVE,
+  DIV_FUR_READ_SAMPLE,
+  DIV_FUR_READ_PATTERN
+};
+
+struct DivFurReadTask {
+  DivFurReadType type;
+  const DivSong* song;
+  const unsigned char* file;
+  size_t len;
+  int index, ptr;
+  bool lazy;
+  // the read instrument/wavetable/sample/pattern
+  void* result;
+  // pattern channel and index
+  int chan, patIndex;
+  // where the reader stopped
+  size_t endPos;
+  bool eof;
+  // lastError and log message if reading failed
+  String error, log;
+  void free() {
+    switch (type) {
+      case DIV_FUR_READ_INS:
+        delete (DivInstrument*)result;
+        break;
+      case DIV_FUR_READ_WAVE:
+        delete (DivWavetable*)result;
+        break;
+      case DIV_FUR_READ_SAMPLE:
+        delete (DivSample*)result;
+        break;
+      case DIV_FUR_READ_PATTERN:
+        delete (DivPattern*)result;
+        break;
+    }
+    result=NULL;
+  }
+  DivFurReadTask(DivFurReadType t, const DivSong* s, const unsigned char* f, size_t l, int i, int p, bool lz):
+    type(t),
+    song(s),
+    file(f),
+    len(l),
+    index(i),
+    ptr(p),
+    lazy(lz),
+    result(NULL),
+    chan(0),
+    patIndex(0),
+    endPos(0),
+    eof(false),
+    error(""),
+    log("") {}
+};
+
+static void _readFurIns(DivFurReadTask* task, SafeReader& reader) {
+  DivInstrument* ins=new DivInstrument;
+  task->result=ins;
+  reader.seek(task->ptr,SEEK_SET);
+
+  if (ins->readInsData(reader,task->song->version)!=DIV_DATA_SUCCESS) {
+    task->error="invalid instrument header/data!";
+  }
+}
+
+static void _readFurWave(DivFurReadTask* task, SafeReader& reader) {
+  DivWavetable* wave=new DivWavetable;
+  task->result=wave;
+  reader.seek(task->ptr,SEEK_SET);
+
+  if (wave->readWaveData(reader,task->song->version)!=DIV_DATA_SUCCESS) {
+    task->error="invalid wavetable header/data!";
+  }
+}
+
+static void _readFurSample(DivFurReadTask* task, SafeReader& reader) {
+  const DivSong& ds=*task->song;
+  int i=task->index;
+  int vol=0;
+  int pitch=0;
+  char magic[5];
+  memset(magic,0,5);
+
+  reader.seek(task->ptr,SEEK_SET);
+  reader.read(magic,4);
+  if (strcmp(magic,"SMPL")!=0) {
+    task->log=fmt::sprintf("%d: invalid sample header!",i);
+    task->error="invalid sample header!";
+    return;
+  }
+  reader.readI();
+  DivSample* sample=new DivSample;
+  task->result=sample;
+
+  sample->name=reader.readString();
+  sample->samples=reader.readI();
+  sample->rate=reader.readI();
+  if (ds.version<58) {
+    vol=reader.readS();
+    pitch=reader.readS();
+  } else {
+    reader.readI();
+  }
+  sample->depth=reader.readC();
+
+  // reserved
+  reader.readC();
+
+  // while version 32 stored this value, it was unused.
+  if (ds.version>=38) {
+    sample->centerRate=(unsigned short) reader.readS();
+  } else {
+    reader.readS();
+  }
+
+  if (ds.version>=19) {
+    sample->loopStart=reader.readI();
+  } else {
+    reader.readI();
+  }
+
+  if (ds.version>=58) { // modern sample
+    if (task->lazy) {
+      // read later by loadLazy()
+      sample->lazyData=task->file+reader.tell();
+      sample->lazyLen=task->len-reader.tell();
+    } else {
+      sample->init(sample->samples);
+      reader.read(sample->getCurBuf(),sample->getCurBufLen());
+    }
+  } else { // legacy sample
+    int length=sample->samples;
+    short* data=new short[length];
+    reader.read(data,2*length);
+
+    if (pitch!=5) {
+      logD("%d: scaling from %d...\n",i,pitch);
+    }
+
+    // render data
+    if (sample->depth!=8 && sample->depth!=16) {
+      logW("%d: sample depth is wrong! (%d)\n",i,sample->depth);
+      sample->depth=16;
+    }
+    sample->samples=(double)sample->samples/samplePitches[pitch];
+    sample->init(sample->samples);
+
+    unsigned int k=0;
+    float mult=(float)(vol)/50.0f;
+    for (double j=0; j<length; j+=samplePitches[pitch]) {
+      if (k>=sample->samples) {
+        break;
+      }
+      if (sample->depth==8) {
+        float next=(float)(data[(unsigned int)j]-0x80)*mult;
+        sample->data8[k++]=fmin(fmax(next,-128),127);
+      } else {
+        float next=(float)data[(unsigned int)j]*mult;
+        sample->data16[k++]=fmin(fmax(next,-32768),32767);
+      }
+    }
+
+    delete[] data;
+  }
+}
+
+static void _readFurPattern(DivFurReadTask* task, SafeReader& reader) {
+  const DivSong& ds=*task->song;
+  char magic[5];
+  memset(magic,0,5);
+
+  reader.seek(task->ptr,SEEK_SET);
+  reader.read(magic,4);
+  if (strcmp(magic,"PATR")!=0) {
+    task->log=fmt::sprintf("%x: invalid pattern header!",task->ptr);
+    task->error="invalid pattern header!";
+    return;
+  }
+  reader.readI();
+
+  int chan=reader.readS();
+  int index=reader.readS();
+  reader.readI();
+
+  if (chan<0 || chan>=DIV_MAX_CHANS || index<0 || index>=128) {
+    task->log=fmt::sprintf("%x: invalid pattern %d in channel %d!",task->ptr,index,chan);
+    task->error="invalid pattern header!";
+    return;
+  }
+  task->chan=chan;
+  task->patIndex=index;
+
+  // the rows are read later by getPattern()
+  if (task->lazy) return;
+
+  DivPattern* pat=new DivPattern(ds.patLen);
+  task->result=pat;
+  for (int j=0; j<ds.patLen; j++) {
+    pat->data[j][0]=reader.readS();
+    pat->data[j][1]=reader.readS();
+    pat->data[j][2]=reader.readS();
+    pat->data[j][3]=reader.readS();
+    for (int k=0; k<ds.pat[chan].effectRows; k++) {
+      pat->data[j][4+(k<<1)]=reader.readS();
+      pat->data[j][5+(k<<1)]=reader.readS();
+    }
+  }
+
+  if (ds.version>=51) {
+    pat->name=reader.readString();
+  }
+}
+
+static void _readFurSection(void* t) {
+  DivFurReadTask* task=(DivFurReadTask*)t;
+  SafeReader reader=SafeReader((void*)task->file,task->len);
+  try {
+    switch (task->type) {
+      case DIV_FUR_READ_INS:
+        _readFurIns(task,reader);
+        break;
+      case DIV_FUR_READ_WAVE:
+        _readFurWave(task,reader);
+        break;
+      case DIV_FUR_READ_SAMPLE:
+        _readFurSample(task,reader);
+        break;
+      case DIV_FUR_READ_PATTERN:
+        _readFurPattern(task,reader);
+        break;
+    }
+  } catch (EndOfFileException e) {
+    task->eof=true;
+  }
+  task->endPos=reader.tell();
+}
+
+bool DivEngine::loadFur(const unsigned char* file, size_t len, bool lazy, unsigned char*& owned) {
   int insPtr[256];
   int wavePtr[256];
   int samplePtr[256];
   std::vector<int> patPtr;
   char magic[5];
   memset(magic,0,5);
-  SafeReader reader=SafeReader(file,len);
+  SafeReader reader=SafeReader((void*)file,len);
   warnings="";
   try {
     DivSong ds;
@@ -756,7 +983,6 @@ bool DivEngine::loadFur(unsigned char* file, size_t len) {
     if (!reader.seek(16,SEEK_SET)) {
       logE("premature end of file!\n");
       lastError="incomplete file";
-      delete[] file;
       return false;
     }
     ds.version=reader.readS();
@@ -811,7 +1037,6 @@ bool DivEngine::loadFur(unsigned char* file, size_t len) {
     if (strcmp(magic,"INFO")!=0) {
       logE("invalid info header!\n");
       lastError="invalid info header!";
-      delete[] file;
       return false;
     }
     reader.readI();
@@ -825,6 +1050,12 @@ bool DivEngine::loadFur(unsigned char* file, size_t len) {
     if (ds.hz!=50 && ds.hz!=60) ds.customTempo=true;
 
     ds.patLen=reader.readS();
+    if (ds.patLen<0 || ds.patLen>256) {
+      logE("invalid pattern length %d!\n",ds.patLen);
+      lastError="file is corrupt or unreadable at pattern length";
+      return false;
+    }
+    ds.setPatLen(ds.patLen);
     ds.ordersLen=reader.readS();
 
     ds.hilightA=reader.readC();
@@ -1022,156 +1253,97 @@ bool DivEngine::loadFur(unsigned char* file, size_t len) {
       ds.masterVol=2.0f;
     }
 
-    // read instruments
+    // read instruments, wavetables, samples and patterns.
+    // these are independent of each other, so they are read in parallel.
+    std::vector<DivFurReadTask> tasks;
+    tasks.reserve(ds.insLen+ds.waveLen+ds.sampleLen+patPtr.size());
     for (int i=0; i<ds.insLen; i++) {
-      DivInstrument* ins=new DivInstrument;
-      reader.seek(insPtr[i],SEEK_SET);
-      
-      if (ins->readInsData(reader,ds.version)!=DIV_DATA_SUCCESS) {
-        lastError="invalid instrument header/data!";
-        delete ins;
-        delete[] file;
-        return false;
-      }
-
-      ds.ins.push_back(ins);
+      tasks.push_back(DivFurReadTask(DIV_FUR_READ_INS,&ds,file,len,i,insPtr[i],lazy));
     }
-
-    // read wavetables
     for (int i=0; i<ds.waveLen; i++) {
-      DivWavetable* wave=new DivWavetable;
-      reader.seek(wavePtr[i],SEEK_SET);
-
-      if (wave->readWaveData(reader,ds.version)!=DIV_DATA_SUCCESS) {
-        lastError="invalid wavetable header/data!";
-        delete wave;
-        delete[] file;
-        return false;
-      }
-
-      ds.wave.push_back(wave);
+      tasks.push_back(DivFurReadTask(DIV_FUR_READ_WAVE,&ds,file,len,i,wavePtr[i],lazy));
     }
-
-    // read samples
     for (int i=0; i<ds.sampleLen; i++) {
-      int vol=0;
-      int pitch=0;
-
-      reader.seek(samplePtr[i],SEEK_SET);
-      reader.read(magic,4);
-      if (strcmp(magic,"SMPL")!=0) {
-        logE("%d: invalid sample header!\n",i);
-        lastError="invalid sample header!";
-        delete[] file;
-        return false;
-      }
-      reader.readI();
-      DivSample* sample=new DivSample;
-
-      sample->name=reader.readString();
-      sample->samples=reader.readI();
-      sample->rate=reader.readI();
-      if (ds.version<58) {
-        vol=reader.readS();
-        pitch=reader.readS();
-      } else {
-        reader.readI();
-      }
-      sample->depth=reader.readC();
-
-      // reserved
-      reader.readC();
-
-      // while version 32 stored this value, it was unused.
-      if (ds.version>=38) {
-        sample->centerRate=(unsigned short) reader.readS();
+      tasks.push_back(DivFurReadTask(DIV_FUR_READ_SAMPLE,&ds,file,len,i,samplePtr[i],lazy));
+    }
+    for (size_t i=0; i<patPtr.size(); i++) {
+      tasks.push_back(DivFurReadTask(DIV_FUR_READ_PATTERN,&ds,file,len,i,patPtr[i],lazy));
+    }
+    if (tasks.size()>1) initSamplePool();
+    for (DivFurReadTask& i: tasks) {
+      if (samplePool!=NULL) {
+        samplePool->push(_readFurSection,&i);
       } else {
-        reader.readS();
+        _readFurSection(&i);
       }
+    }
+    if (samplePool!=NULL) samplePool->wait();
 
-      if (ds.version>=19) {
-        sample->loopStart=reader.readI();
+    // report the first error in file order
+    for (DivFurReadTask& i: tasks) {
+      if (i.eof) {
+        logE("premature end of file!\n");
+        lastError="incomplete file";
+      } else if (!i.error.empty()) {
+        if (!i.log.empty()) logE("%s\n",i.log.c_str());
+        lastError=i.error;
       } else {
-        reader.readI();
+        continue;
       }
+      for (DivFurReadTask& j: tasks) j.free();
+      return false;
+    }
 
-      if (ds.version>=58) { // modern sample
-        sample->init(sample->samples);
-        reader.read(sample->getCurBuf(),sample->getCurBufLen());
-      } else { // legacy sample
-        int length=sample->samples;
-        short* data=new short[length];
-        reader.read(data,2*length);
-
-        if (pitch!=5) {
-          logD("%d: scaling from %d...\n",i,pitch);
-        }
-
-        // render data
-        if (sample->depth!=8 && sample->depth!=16) {
-          logW("%d: sample depth is wrong! (%d)\n",i,sample->depth);
-          sample->depth=16;
-        }
-        sample->samples=(double)sample->samples/samplePitches[pitch];
-        sample->init(sample->samples);
-
-        unsigned int k=0;
-        float mult=(float)(vol)/50.0f;
-        for (double j=0; j<length; j+=samplePitches[pitch]) {
-          if (k>=sample->samples) {
-            break;
-          }
-          if (sample->depth==8) {
-            float next=(float)(data[(unsigned int)j]-0x80)*mult;
-            sample->data8[k++]=fmin(fmax(next,-128),127);
+    for (DivFurReadTask& i: tasks) {
+      switch (i.type) {
+        case DIV_FUR_READ_INS:
+          ds.ins.push_back((DivInstrument*)i.result);
+          break;
+        case DIV_FUR_READ_WAVE:
+          ds.wave.push_back((DivWavetable*)i.result);
+          break;
+        case DIV_FUR_READ_SAMPLE:
+          ds.sample.push_back((DivSample*)i.result);
+          break;
+        case DIV_FUR_READ_PATTERN:
+          if (lazy) {
+            // read later by getPattern()
+            ds.pat[i.chan].lazyPtr[i.patIndex]=i.endPos;
           } else {
-            float next=(float)data[(unsigned int)j]*mult;
-            sample->data16[k++]=fmin(fmax(next,-32768),32767);
+            if (ds.pat[i.chan].data[i.patIndex]!=NULL) delete ds.pat[i.chan].data[i.patIndex];
+            ds.pat[i.chan].data[i.patIndex]=(DivPattern*)i.result;
           }
-        }
-
-        delete[] data;
+          break;
       }
-
-      ds.sample.push_back(sample);
+      i.result=NULL;
     }
 
-    // read patterns
-    for (int i: patPtr) {
-      reader.seek(i,SEEK_SET);
-      reader.read(magic,4);
-      if (strcmp(magic,"PATR")!=0) {
-        logE("%x: invalid pattern header!\n",i);
-        lastError="invalid pattern header!";
-        delete[] file;
-        return false;
+    size_t endPos=tasks.empty()?reader.tell():tasks.back().endPos;
+    if (endPos<reader.size()) {
+      if ((endPos+1)!=reader.size()) {
+        logW("premature end of song (we are at %x, but size is %x)\n",endPos,reader.size());
       }
-      reader.readI();
-
-      int chan=reader.readS();
-      int index=reader.readS();
-      reader.readI();
+    }
 
-      DivPattern* pat=ds.pat[chan].getPattern(index,true);
-      for (int j=0; j<ds.patLen; j++) {
-        pat->data[j][0]=reader.readS();
-        pat->data[j][1]=reader.readS();
-        pat->data[j][2]=reader.readS();
-        pat->data[j][3]=reader.readS();
-        for (int k=0; k<ds.pat[chan].effectRows; k++) {
-          pat->data[j][4+(k<<1)]=reader.readS();
-          pat->data[j][5+(k<<1)]=reader.readS();
-        }
+    if (lazy) {
+      // the file may go away after loading, so keep it (or a copy of it)
+      if (owned!=NULL) {
+        ds.lazyData=owned;
+        owned=NULL;
+      } else {
+        ds.lazyData=new unsigned char[len];
+        memcpy(ds.lazyData,file,len);
       }
-
-      if (ds.version>=51) {
-        pat->name=reader.readString();
+      ds.lazyLen=len;
+      for (DivSample* i: ds.sample) {
+        if (i->lazyData!=NULL) i->lazyData=ds.lazyData+(i->lazyData-file);
       }
-    }
-
-    if (reader.tell()<reader.size()) {
-      if ((reader.tell()+1)!=reader.size()) {
-        logW("premature end of song (we are at %x, but size is %x)\n",reader.tell(),reader.size());
+      for (int i=0; i<DIV_MAX_CHANS; i++) {
+        ds.pat[i].lazyData=ds.lazyData;
+        ds.pat[i].lazyLen=len;
+        ds.pat[i].lazyVersion=ds.version;
+        ds.pat[i].lazyPatLen=ds.patLen;
+        ds.pat[i].lazyEffectRows=ds.pat[i].effectRows;
       }
     }
 
@@ -1189,20 +1361,24 @@ bool DivEngine::loadFur(unsigned char* file, size_t len) {
   } catch (EndOfFileException e) {
     logE("premature end of file!\n");
     lastError="incomplete file";
-    delete[] file;
     return false;
   }
-  delete[] file;
   return true;
 }
 
 bool DivEngine::load(unsigned char* f, size_t slen) {
-  unsigned char* file;
+  bool ret=loadBuffer(f,slen);
+  delete[] f;
+  return ret;
+}
+
+bool DivEngine::loadBuffer(const unsigned char* f, size_t slen, bool lazy) {
+  const unsigned char* file;
+  unsigned char* inflated=NULL;
   size_t len;
   if (slen<16) {
     logE("too small!");
     lastError="file is too small";
-    delete[] f;
     return false;
   }
   if (memcmp(f,DIV_DMF_MAGIC,16)!=0 && memcmp(f,DIV_FUR_MAGIC,16)!=0) {
@@ -1226,16 +1402,24 @@ bool DivEngine::load(unsigned char* f, size_t slen) {
         logE("zlib error: %s\n",zl.msg);
       }
       inflateEnd(&zl);
-      delete[] f;
       lastError="not a .dmf song";
       return false;
     }
 
-    std::vector<InflateBlock*> blocks;
+    // inflate into a single buffer which grows as needed
+    size_t cap=MAX(slen*4,DIV_READ_SIZE);
+    size_t pos=0;
+    inflated=new unsigned char[cap];
     while (true) {
-      InflateBlock* ib=new InflateBlock(DIV_READ_SIZE);
-      zl.next_out=ib->buf;
-      zl.avail_out=ib->len;
+      if (pos>=cap) {
+        unsigned char* grown=new unsigned char[cap*2];
+        memcpy(grown,inflated,pos);
+        delete[] inflated;
+        inflated=grown;
+        cap*=2;
+      }
+      zl.next_out=inflated+pos;
+      zl.avail_out=MIN(cap-pos,0x40000000);
 
       nextErr=inflate(&zl,Z_SYNC_FLUSH);
       if (nextErr!=Z_OK && nextErr!=Z_STREAM_END) {
@@ -1246,15 +1430,11 @@ bool DivEngine::load(unsigned char* f, size_t slen) {
           logE("zlib inflate: %s\n",zl.msg);
           lastError=fmt::sprintf("decompression error: %s",zl.msg);
         }
-        for (InflateBlock* i: blocks) delete i;
-        blocks.clear();
-        delete ib;
+        delete[] inflated;
         inflateEnd(&zl);
-        delete[] f;
         return false;
       }
-      ib->blockSize=ib->len-zl.avail_out;
-      blocks.push_back(ib);
+      pos=zl.next_out-inflated;
       if (nextErr==Z_STREAM_END) {
         break;
       }
@@ -1268,48 +1448,34 @@ bool DivEngine::load(unsigned char* f, size_t slen) {
         logE("zlib end: %s\n",zl.msg);
         lastError=fmt::sprintf("decompression finish error: %s",zl.msg);
       }
-      for (InflateBlock* i: blocks) delete i;
-      blocks.clear();
-      delete[] f;
+      delete[] inflated;
       return false;
     }
 
-    size_t finalSize=0;
-    size_t curSeek=0;
-    for (InflateBlock* i: blocks) {
-      finalSize+=i->blockSize;
-    }
-    if (finalSize<1) {
+    if (pos<16) {
       logE("compressed too small!\n");
       lastError="file too small";
-      for (InflateBlock* i: blocks) delete i;
-      blocks.clear();
-      delete[] f;
+      delete[] inflated;
       return false;
     }
-    file=new unsigned char[finalSize];
-    for (InflateBlock* i: blocks) {
-      memcpy(&file[curSeek],i->buf,i->blockSize);
-      curSeek+=i->blockSize;
-      delete i;
-    }
-    blocks.clear();
-    len=finalSize;
-    delete[] f;
+    file=inflated;
+    len=pos;
   } else {
     logD("loading as uncompressed\n");
-    file=(unsigned char*)f;
+    file=f;
     len=slen;
   }
+  bool ret=false;
   if (memcmp(file,DIV_DMF_MAGIC,16)==0) {
-    return loadDMF(file,len); 
+    ret=loadDMF(file,len); 
   } else if (memcmp(file,DIV_FUR_MAGIC,16)==0) {
-    return loadFur(file,len);
+    ret=loadFur(file,len,lazy,inflated);
+  } else {
+    logE("not a valid module!\n");
+    lastError="not a compatible song";
   }
-  logE("not a valid module!\n");
-  lastError="not a compatible song";
-  delete[] file;
-  return false;
+  delete[] inflated;
+  return ret;
 }
 
 SafeWriter* DivEngine::saveFur() {
@@ -1502,6 +1668,7 @@ SafeWriter* DivEngine::saveFur() {
     w->writeS(sample->centerRate);
     w->writeI(sample->loopStart);
 
+    sample->loadLazy();
     w->write(sample->getCurBuf(),sample->getCurBufLen());
   }
 
@@ -1831,6 +1998,8 @@ SafeWriter* DivEngine::saveDMF(unsigned char version) {
 
   w->writeC(song.sample.size());
   for (DivSample* i: song.sample) {
+    // no chip needed this sample yet, so there is no 16-bit data
+    if (i->lazyData!=NULL) i->render(0);
     w->writeI(i->samples);
     w->writeString(i->name,true);
     w->writeC(divToFileRate(i->rate));
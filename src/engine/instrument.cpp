@@ -23,6 +23,77 @@
 #include "../ta-log.h"
 #include "../fileutils.h"
 
+#define FOR_EACH_STD_MACRO(f) \
+  f(volMacro) \
+  f(arpMacro) \
+  f(dutyMacro) \
+  f(waveMacro) \
+  f(pitchMacro) \
+  f(ex1Macro) \
+  f(ex2Macro) \
+  f(ex3Macro) \
+  f(algMacro) \
+  f(fbMacro) \
+  f(fmsMacro) \
+  f(amsMacro)
+
+#define FOR_EACH_OP_MACRO(f) \
+  f(amMacro) \
+  f(arMacro) \
+  f(drMacro) \
+  f(multMacro) \
+  f(rrMacro) \
+  f(slMacro) \
+  f(tlMacro) \
+  f(dt2Macro) \
+  f(rsMacro) \
+  f(dtMacro) \
+  f(d2rMacro) \
+  f(ssgMacro) \
+  f(damMacro) \
+  f(dvbMacro) \
+  f(egtMacro) \
+  f(kslMacro) \
+  f(susMacro) \
+  f(vibMacro) \
+  f(wsMacro) \
+  f(ksrMacro)
+
+void DivInstrumentSTD::reserveMacros() {
+#define RESERVE_MACRO(x) x.reserve(x##Len);
+  FOR_EACH_STD_MACRO(RESERVE_MACRO)
+  for (int i=0; i<4; i++) {
+    OpMacro& op=opMacros[i];
+#define RESERVE_OP_MACRO(x) op.x.reserve(op.x##Len);
+    FOR_EACH_OP_MACRO(RESERVE_OP_MACRO)
+  }
+}
+
+void DivInstrumentSTD::expandMacros() {
+#define EXPAND_MACRO(x) x.reserve(256);
+  FOR_EACH_STD_MACRO(EXPAND_MACRO)
+  for (int i=0; i<4; i++) {
+    OpMacro& op=opMacros[i];
+#define EXPAND_OP_MACRO(x) op.x.reserve(256);
+    FOR_EACH_OP_MACRO(EXPAND_OP_MACRO)
+  }
+}
+
+void DivInstrumentSTD::shrinkMacros() {
+#define SHRINK_MACRO(x) x.shrink(x##Len);
+  FOR_EACH_STD_MACRO(SHRINK_MACRO)
+  for (int i=0; i<4; i++) {
+    OpMacro& op=opMacros[i];
+#define SHRINK_OP_MACRO(x) op.x.shrink(op.x##Len);
+    FOR_EACH_OP_MACRO(SHRINK_OP_MACRO)
+  }
+}
+
+bool DivInstrumentSTD::macrosExpanded() const {
+  // expandMacros() grows the last operator macro last
+  return opMacros[3].ksrMacro.capacity()>=256;
+}
+
 void DivInstrument::putInsData(SafeWriter* w) {
   w->write("INST",4);
   w->writeI(0);
@@ -500,6 +571,7 @@ DivDataErrors DivInstrument::readInsData(SafeReader& reader, short version) {
   if (std.volMacroHeight==0) std.volMacroHeight=15;
   if (std.dutyMacroHeight==0) std.dutyMacroHeight=3;
   if (std.waveMacroHeight==0) std.waveMacroHeight=63;
+  std.reserveMacros();
   reader.read(std.volMacro,4*std.volMacroLen);
   reader.read(std.arpMacro,4*std.arpMacroLen);
   reader.read(std.dutyMacro,4*std.dutyMacroLen);
@@ -548,6 +620,7 @@ DivDataErrors DivInstrument::readInsData(SafeReader& reader, short version) {
     std.fmsMacroOpen=reader.readC();
     std.amsMacroOpen=reader.readC();
 
+    std.reserveMacros();
     reader.read(std.algMacro,4*std.algMacroLen);
     reader.read(std.fbMacro,4*std.fbMacroLen);
     reader.read(std.fmsMacro,4*std.fmsMacroLen);
@@ -596,6 +669,7 @@ DivDataErrors DivInstrument::readInsData(SafeReader& reader, short version) {
       op.ssgMacroOpen=reader.readC();
     }
 
+    std.reserveMacros();
     for (int i=0; i<4; i++) {
       DivInstrumentSTD::OpMacro& op=std.opMacros[i];
       reader.read(op.amMacro,op.amMacroLen);
@@ -688,6 +762,7 @@ DivDataErrors DivInstrument::readInsData(SafeReader& reader, short version) {
       op.ksrMacroOpen=reader.readC();
     }
 
+    std.reserveMacros();
     for (int i=0; i<4; i++) {
       DivInstrumentSTD::OpMacro& op=std.opMacros[i];
       reader.read(op.damMacro,op.damMacroLen);
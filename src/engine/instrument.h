@@ -144,19 +144,100 @@ struct DivInstrumentFM {
   }
 };
 
+// number of macro values stored inline in DivMacroData.
+#define DIV_MACRO_INLINE 8
+
+// storage for the values of a macro.
+// short macros are stored inline, and longer ones are moved to the heap by reserve().
+// reserve() may move the data, so call it before writing past capacity().
+template<typename T> class DivMacroData {
+  T* heap;
+  unsigned short cap;
+  T inl[DIV_MACRO_INLINE];
+  public:
+    T* data() {
+      return heap?heap:inl;
+    }
+    const T* data() const {
+      return heap?heap:inl;
+    }
+    operator T*() {
+      return data();
+    }
+    operator const T*() const {
+      return data();
+    }
+    int capacity() const {
+      return cap;
+    }
+    // grow to hold at least len values. new values are zeroed.
+    void reserve(int len) {
+      if (len<=cap) return;
+      if (len>256) len=256;
+      T* newData=new T[len];
+      memcpy(newData,data(),cap*sizeof(T));
+      memset(newData+cap,0,(len-cap)*sizeof(T));
+      if (heap!=NULL) delete[] heap;
+      heap=newData;
+      cap=len;
+    }
+    // release the storage past the first len values.
+    void shrink(int len) {
+      if (heap==NULL || len>=cap) return;
+      if (len<=DIV_MACRO_INLINE) {
+        memcpy(inl,heap,DIV_MACRO_INLINE*sizeof(T));
+        delete[] heap;
+        heap=NULL;
+        cap=DIV_MACRO_INLINE;
+        return;
+      }
+      T* newData=new T[len];
+      memcpy(newData,heap,len*sizeof(T));
+      delete[] heap;
+      heap=newData;
+      cap=len;
+    }
+    DivMacroData& operator=(const DivMacroData& other) {
+      if (this==&other) return *this;
+      if (heap!=NULL) delete[] heap;
+      heap=NULL;
+      cap=DIV_MACRO_INLINE;
+      memcpy(inl,other.inl,DIV_MACRO_INLINE*sizeof(T));
+      if (other.heap!=NULL) {
+        heap=new T[other.cap];
+        memcpy(heap,other.heap,other.cap*sizeof(T));
+        cap=other.cap;
+      }
+      return *this;
+    }
+    DivMacroData(const DivMacroData& other):
+      heap(NULL),
+      cap(DIV_MACRO_INLINE) {
+      *this=other;
+    }
+    DivMacroData():
+      heap(NULL),
+      cap(DIV_MACRO_INLINE) {
+      memset(inl,0,DIV_MACRO_INLINE*sizeof(T));
+    }
+    ~DivMacroData() {
+      if (heap!=NULL) delete[] heap;
+    }
+};
+
 struct DivInstrumentSTD {
-  int volMacro[256];
-  int arpMacro[256];
-  int dutyMacro[256];
-  int waveMacro[256];
-  int pitchMacro[256];
-  int ex1Macro[256];
-  int ex2Macro[256];
-  int ex3Macro[256];
-  int algMacro[256];
-  int fbMacro[256];
-  int fmsMacro[256];
-  int amsMacro[256];
+  DivMacroData<int> volMacro;
+  DivMacroData<int> arpMacro;
+  DivMacroData<int> dutyMacro;
+  DivMacroData<int> waveMacro;
+  DivMacroData<int> pitchMacro;
+  DivMacroData<int> ex1Macro;
+  DivMacroData<int> ex2Macro;
+  DivMacroData<int> ex3Macro;
+  DivMacroData<int> algMacro;
+  DivMacroData<int> fbMacro;
+  DivMacroData<int> fmsMacro;
+  DivMacroData<int> amsMacro;
   bool arpMacroMode;
   unsigned char volMacroHeight, dutyMacroHeight, waveMacroHeight;
   bool volMacroOpen, arpMacroOpen, dutyMacroOpen, waveMacroOpen;
@@ -173,26 +254,26 @@ struct DivInstrumentSTD {
   signed char algMacroRel, fbMacroRel, fmsMacroRel, amsMacroRel;
   struct OpMacro {
     // ar, dr, mult, rr, sl, tl, dt2, rs, dt, d2r, ssgEnv;
-    unsigned char amMacro[256];
-    unsigned char arMacro[256];
-    unsigned char drMacro[256];
-    unsigned char multMacro[256];
-    unsigned char rrMacro[256];
-    unsigned char slMacro[256];
-    unsigned char tlMacro[256];
-    unsigned char dt2Macro[256];
-    unsigned char rsMacro[256];
-    unsigned char dtMacro[256];
-    unsigned char d2rMacro[256];
-    unsigned char ssgMacro[256];
-    unsigned char damMacro[256];
-    unsigned char dvbMacro[256];
-    unsigned char egtMacro[256];
-    unsigned char kslMacro[256];
-    unsigned char susMacro[256];
-    unsigned char vibMacro[256];
-    unsigned char wsMacro[256];
-    unsigned char ksrMacro[256];
+    DivMacroData<unsigned char> amMacro;
+    DivMacroData<unsigned char> arMacro;
+    DivMacroData<unsigned char> drMacro;
+    DivMacroData<unsigned char> multMacro;
+    DivMacroData<unsigned char> rrMacro;
+    DivMacroData<unsigned char> slMacro;
+    DivMacroData<unsigned char> tlMacro;
+    DivMacroData<unsigned char> dt2Macro;
+    DivMacroData<unsigned char> rsMacro;
+    DivMacroData<unsigned char> dtMacro;
+    DivMacroData<unsigned char> d2rMacro;
+    DivMacroData<unsigned char> ssgMacro;
+    DivMacroData<unsigned char> damMacro;
+    DivMacroData<unsigned char> dvbMacro;
+    DivMacroData<unsigned char> egtMacro;
+    DivMacroData<unsigned char> kslMacro;
+    DivMacroData<unsigned char> susMacro;
+    DivMacroData<unsigned char> vibMacro;
+    DivMacroData<unsigned char> wsMacro;
+    DivMacroData<unsigned char> ksrMacro;
     bool amMacroOpen, arMacroOpen, drMacroOpen, multMacroOpen;
     bool rrMacroOpen, slMacroOpen, tlMacroOpen, dt2MacroOpen;
     bool rsMacroOpen, dtMacroOpen, d2rMacroOpen, ssgMacroOpen;
@@ -233,29 +314,25 @@ struct DivInstrumentSTD {
       rrMacroRel(-1), slMacroRel(-1), tlMacroRel(-1), dt2MacroRel(-1),
       rsMacroRel(-1), dtMacroRel(-1), d2rMacroRel(-1), ssgMacroRel(-1),
       damMacroRel(-1), dvbMacroRel(-1), egtMacroRel(-1), kslMacroRel(-1),
-      susMacroRel(-1), vibMacroRel(-1), wsMacroRel(-1), ksrMacroRel(-1) {
-        memset(amMacro,0,256);
-        memset(arMacro,0,256);
-        memset(drMacro,0,256);
-        memset(multMacro,0,256);
-        memset(rrMacro,0,256);
-        memset(slMacro,0,256);
-        memset(tlMacro,0,256);
-        memset(dt2Macro,0,256);
-        memset(rsMacro,0,256);
-        memset(dtMacro,0,256);
-        memset(d2rMacro,0,256);
-        memset(ssgMacro,0,256);
-        memset(damMacro,0,256);
-        memset(dvbMacro,0,256);
-        memset(egtMacro,0,256);
-        memset(kslMacro,0,256);
-        memset(susMacro,0,256);
-        memset(vibMacro,0,256);
-        memset(wsMacro,0,256);
-        memset(ksrMacro,0,256);
-      }
+      susMacroRel(-1), vibMacroRel(-1), wsMacroRel(-1), ksrMacroRel(-1) {}
   } opMacros[4];
+  /**
+   * make room for the current length of every macro.
+   * loaders call this after reading the lengths and before reading the values.
+   */
+  void reserveMacros();
+  /**
+   * grow every macro to the maximum length, so that the editor may write to any position.
+   */
+  void expandMacros();
+  /**
+   * shrink every macro back to its current length, undoing expandMacros().
+   */
+  void shrinkMacros();
+  /**
+   * @return whether expandMacros() has been called.
+   */
+  bool macrosExpanded() const;
   DivInstrumentSTD():
     arpMacroMode(false),
     volMacroHeight(15),
@@ -308,20 +385,7 @@ struct DivInstrumentSTD {
     algMacroRel(-1),
     fbMacroRel(-1),
     fmsMacroRel(-1),
-    amsMacroRel(-1) {
-      memset(volMacro,0,256*sizeof(int));
-      memset(arpMacro,0,256*sizeof(int));
-      memset(dutyMacro,0,256*sizeof(int));
-      memset(waveMacro,0,256*sizeof(int));
-      memset(pitchMacro,0,256*sizeof(int));
-      memset(ex1Macro,0,256*sizeof(int));
-      memset(ex2Macro,0,256*sizeof(int));
-      memset(ex3Macro,0,256*sizeof(int));
-      memset(algMacro,0,256*sizeof(int));
-      memset(fbMacro,0,256*sizeof(int));
-      memset(fmsMacro,0,256*sizeof(int));
-      memset(amsMacro,0,256*sizeof(int));
-    }
+    amsMacroRel(-1) {}
 };
 
 struct DivInstrumentGB {
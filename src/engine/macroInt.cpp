@@ -20,76 +20,49 @@
 #include "macroInt.h"
 #include "instrument.h"
 
-#define doMacro(finished,had,has,val,pos,source,sourceLen,sourceLoop,sourceRel) \
-  if (finished) finished=false; \
-  if (had!=has) { \
-    finished=true; \
-  } \
-  had=has; \
-  if (has) { \
-    val=source[pos++]; \
-    if (sourceRel>=0 && pos>sourceRel && !released) { \
-      if (sourceLoop<sourceLen && sourceLoop>=0 && sourceLoop<sourceRel) { \
-        pos=sourceLoop; \
-      } else { \
-        pos--; \
-      } \
-    } \
-    if (pos>=sourceLen) { \
-      if (sourceLoop<sourceLen && sourceLoop>=0 && (sourceLoop>=sourceRel || sourceRel>=sourceLen)) { \
-        pos=sourceLoop; \
-      } else { \
-        has=false; \
-      } \
-    } \
-  }
+#define SLOT_FIELD(t,x) (*(t*)(((unsigned char*)this)+(x)))
+#define INS_FIELD(t,x) (*(t*)(((unsigned char*)ins)+(x)))
 
-// CPU hell
 void DivMacroInt::next() {
   if (ins==NULL) return;
 
-  doMacro(finishedVol,hadVol,hasVol,vol,volPos,ins->std.volMacro,ins->std.volMacroLen,ins->std.volMacroLoop,ins->std.volMacroRel);
-  doMacro(finishedArp,hadArp,hasArp,arp,arpPos,ins->std.arpMacro,ins->std.arpMacroLen,ins->std.arpMacroLoop,ins->std.arpMacroRel);
-  doMacro(finishedDuty,hadDuty,hasDuty,duty,dutyPos,ins->std.dutyMacro,ins->std.dutyMacroLen,ins->std.dutyMacroLoop,ins->std.dutyMacroRel);
-  doMacro(finishedWave,hadWave,hasWave,wave,wavePos,ins->std.waveMacro,ins->std.waveMacroLen,ins->std.waveMacroLoop,ins->std.waveMacroRel);
-
-  doMacro(finishedPitch,hadPitch,hasPitch,pitch,pitchPos,ins->std.pitchMacro,ins->std.pitchMacroLen,ins->std.pitchMacroLoop,ins->std.pitchMacroRel);
-  doMacro(finishedEx1,hadEx1,hasEx1,ex1,ex1Pos,ins->std.ex1Macro,ins->std.ex1MacroLen,ins->std.ex1MacroLoop,ins->std.ex1MacroRel);
-  doMacro(finishedEx2,hadEx2,hasEx2,ex2,ex2Pos,ins->std.ex2Macro,ins->std.ex2MacroLen,ins->std.ex2MacroLoop,ins->std.ex2MacroRel);
-  doMacro(finishedEx3,hadEx3,hasEx3,ex3,ex3Pos,ins->std.ex3Macro,ins->std.ex3MacroLen,ins->std.ex3MacroLoop,ins->std.ex3MacroRel);
-
-  doMacro(finishedAlg,hadAlg,hasAlg,alg,algPos,ins->std.algMacro,ins->std.algMacroLen,ins->std.algMacroLoop,ins->std.algMacroRel);
-  doMacro(finishedFb,hadFb,hasFb,fb,fbPos,ins->std.fbMacro,ins->std.fbMacroLen,ins->std.fbMacroLoop,ins->std.fbMacroRel);
-  doMacro(finishedFms,hadFms,hasFms,fms,fmsPos,ins->std.fmsMacro,ins->std.fmsMacroLen,ins->std.fmsMacroLoop,ins->std.fmsMacroRel);
-  doMacro(finishedAms,hadAms,hasAms,ams,amsPos,ins->std.amsMacro,ins->std.amsMacroLen,ins->std.amsMacroLoop,ins->std.amsMacroRel);
-
-  for (int i=0; i<4; i++) {
-    DivInstrumentSTD::OpMacro& m=ins->std.opMacros[i];
-    IntOp& o=op[i];
-    doMacro(o.finishedAm,o.hadAm,o.hasAm,o.am,o.amPos,m.amMacro,m.amMacroLen,m.amMacroLoop,m.amMacroRel);
-    doMacro(o.finishedAr,o.hadAr,o.hasAr,o.ar,o.arPos,m.arMacro,m.arMacroLen,m.arMacroLoop,m.arMacroRel);
-    doMacro(o.finishedDr,o.hadDr,o.hasDr,o.dr,o.drPos,m.drMacro,m.drMacroLen,m.drMacroLoop,m.drMacroRel);
-    doMacro(o.finishedMult,o.hadMult,o.hasMult,o.mult,o.multPos,m.multMacro,m.multMacroLen,m.multMacroLoop,m.multMacroRel);
-
-    doMacro(o.finishedRr,o.hadRr,o.hasRr,o.rr,o.rrPos,m.rrMacro,m.rrMacroLen,m.rrMacroLoop,m.rrMacroRel);
-    doMacro(o.finishedSl,o.hadSl,o.hasSl,o.sl,o.slPos,m.slMacro,m.slMacroLen,m.slMacroLoop,m.slMacroRel);
-    doMacro(o.finishedTl,o.hadTl,o.hasTl,o.tl,o.tlPos,m.tlMacro,m.tlMacroLen,m.tlMacroLoop,m.tlMacroRel);
-    doMacro(o.finishedDt2,o.hadDt2,o.hasDt2,o.dt2,o.dt2Pos,m.dt2Macro,m.dt2MacroLen,m.dt2MacroLoop,m.dt2MacroRel);
-
-    doMacro(o.finishedRs,o.hadRs,o.hasRs,o.rs,o.rsPos,m.rsMacro,m.rsMacroLen,m.rsMacroLoop,m.rsMacroRel);
-    doMacro(o.finishedDt,o.hadDt,o.hasDt,o.dt,o.dtPos,m.dtMacro,m.dtMacroLen,m.dtMacroLoop,m.dtMacroRel);
-    doMacro(o.finishedD2r,o.hadD2r,o.hasD2r,o.d2r,o.d2rPos,m.d2rMacro,m.d2rMacroLen,m.d2rMacroLoop,m.d2rMacroRel);
-    doMacro(o.finishedSsg,o.hadSsg,o.hasSsg,o.ssg,o.ssgPos,m.ssgMacro,m.ssgMacroLen,m.ssgMacroLoop,m.ssgMacroRel);
-
-    doMacro(o.finishedDam,o.hadDam,o.hasDam,o.dam,o.damPos,m.damMacro,m.damMacroLen,m.damMacroLoop,m.damMacroRel);
-    doMacro(o.finishedDvb,o.hadDvb,o.hasDvb,o.dvb,o.dvbPos,m.dvbMacro,m.dvbMacroLen,m.dvbMacroLoop,m.dvbMacroRel);
-    doMacro(o.finishedEgt,o.hadEgt,o.hasEgt,o.egt,o.egtPos,m.egtMacro,m.egtMacroLen,m.egtMacroLoop,m.egtMacroRel);
-    doMacro(o.finishedKsl,o.hadKsl,o.hasKsl,o.ksl,o.kslPos,m.kslMacro,m.kslMacroLen,m.kslMacroLoop,m.kslMacroRel);
-
-    doMacro(o.finishedSus,o.hadSus,o.hasSus,o.sus,o.susPos,m.susMacro,m.susMacroLen,m.susMacroLoop,m.susMacroRel);
-    doMacro(o.finishedVib,o.hadVib,o.hasVib,o.vib,o.vibPos,m.vibMacro,m.vibMacroLen,m.vibMacroLoop,m.vibMacroRel);
-    doMacro(o.finishedWs,o.hadWs,o.hasWs,o.ws,o.wsPos,m.wsMacro,m.wsMacroLen,m.wsMacroLoop,m.wsMacroRel);
-    doMacro(o.finishedKsr,o.hadKsr,o.hasKsr,o.ksr,o.ksrPos,m.ksrMacro,m.ksrMacroLen,m.ksrMacroLoop,m.ksrMacroRel);
+  for (int i=0; i<slotCount; i++) {
+    DivMacroSlot& s=slots[i];
+    bool& has=SLOT_FIELD(bool,s.has);
+    bool& had=SLOT_FIELD(bool,s.had);
+    bool& finished=SLOT_FIELD(bool,s.finished);
+    if (finished) finished=false;
+    if (had!=has) {
+      finished=true;
+    }
+    had=has;
+    if (has) {
+      unsigned char len=INS_FIELD(unsigned char,s.len);
+      signed char loop=INS_FIELD(signed char,s.loop);
+      signed char rel=INS_FIELD(signed char,s.rel);
+      if (s.isOp) {
+        SLOT_FIELD(int,s.val)=INS_FIELD(DivMacroData<unsigned char>,s.source)[s.pos++];
+      } else {
+        SLOT_FIELD(int,s.val)=INS_FIELD(DivMacroData<int>,s.source)[s.pos++];
+      }
+      if (rel>=0 && s.pos>rel && !released) {
+        if (loop<len && loop>=0 && loop<rel) {
+          s.pos=loop;
+        } else {
+          s.pos--;
+        }
+      }
+      if (s.pos>=len) {
+        if (loop<len && loop>=0 && (loop>=rel || rel>=len)) {
+          s.pos=loop;
+        } else {
+          has=false;
+        }
+      }
+    } else if (!had && !finished) {
+      // the macro is over and its flags have settled, so it won't change anymore
+      slots[i--]=slots[--slotCount];
+    }
   }
 }
 
@@ -97,20 +70,29 @@ void DivMacroInt::release() {
   released=true;
 }
 
+void DivMacroInt::addMacro(int& val, bool& has, bool& had, bool& will, bool& finished, const void* source, bool isOp, unsigned char& len, signed char& loop, signed char& rel) {
+  finished=false;
+  if (len<1) return;
+  had=true;
+  has=true;
+  will=true;
+
+  DivMacroSlot& s=slots[slotCount++];
+  s.source=(const unsigned char*)source-(unsigned char*)ins;
+  s.len=(unsigned char*)&len-(unsigned char*)ins;
+  s.loop=(unsigned char*)&loop-(unsigned char*)ins;
+  s.rel=(unsigned char*)&rel-(unsigned char*)ins;
+  s.isOp=isOp;
+  s.pos=0;
+  s.val=(unsigned char*)&val-(unsigned char*)this;
+  s.has=(unsigned char*)&has-(unsigned char*)this;
+  s.had=(unsigned char*)&had-(unsigned char*)this;
+  s.finished=(unsigned char*)&finished-(unsigned char*)this;
+}
+
 void DivMacroInt::init(DivInstrument* which) {
   ins=which;
-  volPos=0;
-  arpPos=0;
-  dutyPos=0;
-  wavePos=0;
-  pitchPos=0;
-  ex1Pos=0;
-  ex2Pos=0;
-  ex3Pos=0;
-  algPos=0;
-  fbPos=0;
-  fmsPos=0;
-  amsPos=0;
+  slotCount=0;
 
   released=false;
 
@@ -162,66 +144,18 @@ void DivMacroInt::init(DivInstrument* which) {
 
   if (ins==NULL) return;
 
-  if (ins->std.volMacroLen>0) {
-    hadVol=true;
-    hasVol=true;
-    willVol=true;
-  }
-  if (ins->std.arpMacroLen>0) {
-    hadArp=true;
-    hasArp=true;
-    willArp=true;
-  }
-  if (ins->std.dutyMacroLen>0) {
-    hadDuty=true;
-    hasDuty=true;
-    willDuty=true;
-  }
-  if (ins->std.waveMacroLen>0) {
-    hadWave=true;
-    hasWave=true;
-    willWave=true;
-  }
-  if (ins->std.pitchMacroLen>0) {
-    hadPitch=true;
-    hasPitch=true;
-    willPitch=true;
-  }
-  if (ins->std.ex1MacroLen>0) {
-    hadEx1=true;
-    hasEx1=true;
-    willEx1=true;
-  }
-  if (ins->std.ex2MacroLen>0) {
-    hadEx2=true;
-    hasEx2=true;
-    willEx2=true;
-  }
-  if (ins->std.ex3MacroLen>0) {
-    hadEx3=true;
-    hasEx3=true;
-    willEx3=true;
-  }
-  if (ins->std.algMacroLen>0) {
-    hadAlg=true;
-    hasAlg=true;
-    willAlg=true;
-  }
-  if (ins->std.fbMacroLen>0) {
-    hadFb=true;
-    hasFb=true;
-    willFb=true;
-  }
-  if (ins->std.fmsMacroLen>0) {
-    hadFms=true;
-    hasFms=true;
-    willFms=true;
-  }
-  if (ins->std.amsMacroLen>0) {
-    hadAms=true;
-    hasAms=true;
-    willAms=true;
-  }
+  addMacro(vol,hasVol,hadVol,willVol,finishedVol,&ins->std.volMacro,false,ins->std.volMacroLen,ins->std.volMacroLoop,ins->std.volMacroRel);
+  addMacro(arp,hasArp,hadArp,willArp,finishedArp,&ins->std.arpMacro,false,ins->std.arpMacroLen,ins->std.arpMacroLoop,ins->std.arpMacroRel);
+  addMacro(duty,hasDuty,hadDuty,willDuty,finishedDuty,&ins->std.dutyMacro,false,ins->std.dutyMacroLen,ins->std.dutyMacroLoop,ins->std.dutyMacroRel);
+  addMacro(wave,hasWave,hadWave,willWave,finishedWave,&ins->std.waveMacro,false,ins->std.waveMacroLen,ins->std.waveMacroLoop,ins->std.waveMacroRel);
+  addMacro(pitch,hasPitch,hadPitch,willPitch,finishedPitch,&ins->std.pitchMacro,false,ins->std.pitchMacroLen,ins->std.pitchMacroLoop,ins->std.pitchMacroRel);
+  addMacro(ex1,hasEx1,hadEx1,willEx1,finishedEx1,&ins->std.ex1Macro,false,ins->std.ex1MacroLen,ins->std.ex1MacroLoop,ins->std.ex1MacroRel);
+  addMacro(ex2,hasEx2,hadEx2,willEx2,finishedEx2,&ins->std.ex2Macro,false,ins->std.ex2MacroLen,ins->std.ex2MacroLoop,ins->std.ex2MacroRel);
+  addMacro(ex3,hasEx3,hadEx3,willEx3,finishedEx3,&ins->std.ex3Macro,false,ins->std.ex3MacroLen,ins->std.ex3MacroLoop,ins->std.ex3MacroRel);
+  addMacro(alg,hasAlg,hadAlg,willAlg,finishedAlg,&ins->std.algMacro,false,ins->std.algMacroLen,ins->std.algMacroLoop,ins->std.algMacroRel);
+  addMacro(fb,hasFb,hadFb,willFb,finishedFb,&ins->std.fbMacro,false,ins->std.fbMacroLen,ins->std.fbMacroLoop,ins->std.fbMacroRel);
+  addMacro(fms,hasFms,hadFms,willFms,finishedFms,&ins->std.fmsMacro,false,ins->std.fmsMacroLen,ins->std.fmsMacroLoop,ins->std.fmsMacroRel);
+  addMacro(ams,hasAms,hadAms,willAms,finishedAms,&ins->std.amsMacro,false,ins->std.amsMacroLen,ins->std.amsMacroLoop,ins->std.amsMacroRel);
 
   if (ins->std.arpMacroMode) {
     arpMode=true;
@@ -231,107 +165,26 @@ void DivMacroInt::init(DivInstrument* which) {
     DivInstrumentSTD::OpMacro& m=ins->std.opMacros[i];
     IntOp& o=op[i];
 
-    if (m.amMacroLen>0) {
-      o.hadAm=true;
-      o.hasAm=true;
-      o.willAm=true;
-    }
-    if (m.arMacroLen>0) {
-      o.hadAr=true;
-      o.hasAr=true;
-      o.willAr=true;
-    }
-    if (m.drMacroLen>0) {
-      o.hadDr=true;
-      o.hasDr=true;
-      o.willDr=true;
-    }
-    if (m.multMacroLen>0) {
-      o.hadMult=true;
-      o.hasMult=true;
-      o.willMult=true;
-    }
-    if (m.rrMacroLen>0) {
-      o.hadRr=true;
-      o.hasRr=true;
-      o.willRr=true;
-    }
-    if (m.slMacroLen>0) {
-      o.hadSl=true;
-      o.hasSl=true;
-      o.willSl=true;
-    }
-    if (m.tlMacroLen>0) {
-      o.hadTl=true;
-      o.hasTl=true;
-      o.willTl=true;
-    }
-    if (m.dt2MacroLen>0) {
-      o.hadDt2=true;
-      o.hasDt2=true;
-      o.willDt2=true;
-    }
-    if (m.rsMacroLen>0) {
-      o.hadRs=true;
-      o.hasRs=true;
-      o.willRs=true;
-    }
-    if (m.dtMacroLen>0) {
-      o.hadDt=true;
-      o.hasDt=true;
-      o.willDt=true;
-    }
-    if (m.d2rMacroLen>0) {
-      o.hadD2r=true;
-      o.hasD2r=true;
-      o.willD2r=true;
-    }
-    if (m.ssgMacroLen>0) {
-      o.hadSsg=true;
-      o.hasSsg=true;
-      o.willSsg=true;
-    }
-
-    if (m.damMacroLen>0) {
-      o.hadDam=true;
-      o.hasDam=true;
-      o.willDam=true;
-    }
-    if (m.dvbMacroLen>0) {
-      o.hadDvb=true;
-      o.hasDvb=true;
-      o.willDvb=true;
-    }
-    if (m.egtMacroLen>0) {
-      o.hadEgt=true;
-      o.hasEgt=true;
-      o.willEgt=true;
-    }
-    if (m.kslMacroLen>0) {
-      o.hadKsl=true;
-      o.hasKsl=true;
-      o.willKsl=true;
-    }
-    if (m.susMacroLen>0) {
-      o.hadSus=true;
-      o.hasSus=true;
-      o.willSus=true;
-    }
-    if (m.vibMacroLen>0) {
-      o.hadVib=true;
-      o.hasVib=true;
-      o.willVib=true;
-    }
-    if (m.wsMacroLen>0) {
-      o.hadWs=true;
-      o.hasWs=true;
-      o.willWs=true;
-    }
-    if (m.ksrMacroLen>0) {
-      o.hadKsr=true;
-      o.hasKsr=true;
-      o.willKsr=true;
-    }
+    addMacro(o.am,o.hasAm,o.hadAm,o.willAm,o.finishedAm,&m.amMacro,true,m.amMacroLen,m.amMacroLoop,m.amMacroRel);
+    addMacro(o.ar,o.hasAr,o.hadAr,o.willAr,o.finishedAr,&m.arMacro,true,m.arMacroLen,m.arMacroLoop,m.arMacroRel);
+    addMacro(o.dr,o.hasDr,o.hadDr,o.willDr,o.finishedDr,&m.drMacro,true,m.drMacroLen,m.drMacroLoop,m.drMacroRel);
+    addMacro(o.mult,o.hasMult,o.hadMult,o.willMult,o.finishedMult,&m.multMacro,true,m.multMacroLen,m.multMacroLoop,m.multMacroRel);
+    addMacro(o.rr,o.hasRr,o.hadRr,o.willRr,o.finishedRr,&m.rrMacro,true,m.rrMacroLen,m.rrMacroLoop,m.rrMacroRel);
+    addMacro(o.sl,o.hasSl,o.hadSl,o.willSl,o.finishedSl,&m.slMacro,true,m.slMacroLen,m.slMacroLoop,m.slMacroRel);
+    addMacro(o.tl,o.hasTl,o.hadTl,o.willTl,o.finishedTl,&m.tlMacro,true,m.tlMacroLen,m.tlMacroLoop,m.tlMacroRel);
+    addMacro(o.dt2,o.hasDt2,o.hadDt2,o.willDt2,o.finishedDt2,&m.dt2Macro,true,m.dt2MacroLen,m.dt2MacroLoop,m.dt2MacroRel);
+    addMacro(o.rs,o.hasRs,o.hadRs,o.willRs,o.finishedRs,&m.rsMacro,true,m.rsMacroLen,m.rsMacroLoop,m.rsMacroRel);
+    addMacro(o.dt,o.hasDt,o.hadDt,o.willDt,o.finishedDt,&m.dtMacro,true,m.dtMacroLen,m.dtMacroLoop,m.dtMacroRel);
+    addMacro(o.d2r,o.hasD2r,o.hadD2r,o.willD2r,o.finishedD2r,&m.d2rMacro,true,m.d2rMacroLen,m.d2rMacroLoop,m.d2rMacroRel);
+    addMacro(o.ssg,o.hasSsg,o.hadSsg,o.willSsg,o.finishedSsg,&m.ssgMacro,true,m.ssgMacroLen,m.ssgMacroLoop,m.ssgMacroRel);
+    addMacro(o.dam,o.hasDam,o.hadDam,o.willDam,o.finishedDam,&m.damMacro,true,m.damMacroLen,m.damMacroLoop,m.damMacroRel);
+    addMacro(o.dvb,o.hasDvb,o.hadDvb,o.willDvb,o.finishedDvb,&m.dvbMacro,true,m.dvbMacroLen,m.dvbMacroLoop,m.dvbMacroRel);
+    addMacro(o.egt,o.hasEgt,o.hadEgt,o.willEgt,o.finishedEgt,&m.egtMacro,true,m.egtMacroLen,m.egtMacroLoop,m.egtMacroRel);
+    addMacro(o.ksl,o.hasKsl,o.hadKsl,o.willKsl,o.finishedKsl,&m.kslMacro,true,m.kslMacroLen,m.kslMacroLoop,m.kslMacroRel);
+    addMacro(o.sus,o.hasSus,o.hadSus,o.willSus,o.finishedSus,&m.susMacro,true,m.susMacroLen,m.susMacroLoop,m.susMacroRel);
+    addMacro(o.vib,o.hasVib,o.hadVib,o.willVib,o.finishedVib,&m.vibMacro,true,m.vibMacroLen,m.vibMacroLoop,m.vibMacroRel);
+    addMacro(o.ws,o.hasWs,o.hadWs,o.willWs,o.finishedWs,&m.wsMacro,true,m.wsMacroLen,m.wsMacroLoop,m.wsMacroRel);
+    addMacro(o.ksr,o.hasKsr,o.hadKsr,o.willKsr,o.finishedKsr,&m.ksrMacro,true,m.ksrMacroLen,m.ksrMacroLoop,m.ksrMacroRel);
   }
 }
 
@@ -22,11 +22,28 @@
 
 #include "instrument.h"
 
+// 12 standard macros and 20 macros per operator.
+#define DIV_MACRO_MAX (12+20*4)
+
+// a running macro.
+// source/len/loop/rel are offsets of the macro's fields in DivInstrument, which are read on every tick
+// so that edits are heard while the macro runs, and so that the editor may move the macro's data.
+// val/has/had/finished are offsets of the fields it updates in DivMacroInt,
+// so that copies of the latter stay valid.
+struct DivMacroSlot {
+  short pos;
+  bool isOp;
+  unsigned int source, len, loop, rel;
+  unsigned short val, has, had, finished;
+};
+
 class DivMacroInt {
   DivInstrument* ins;
-  int volPos, arpPos, dutyPos, wavePos, pitchPos, ex1Pos, ex2Pos, ex3Pos;
-  int algPos, fbPos, fmsPos, amsPos;
+  // only the macros which are running (or have just finished) are stepped in next().
+  DivMacroSlot slots[DIV_MACRO_MAX];
+  int slotCount;
   bool released;
+  void addMacro(int& val, bool& has, bool& had, bool& will, bool& finished, const void* source, bool isOp, unsigned char& len, signed char& loop, signed char& rel);
   public:
     int vol;
     int arp;
@@ -39,12 +56,6 @@ class DivMacroInt {
     bool willVol, willArp, willDuty, willWave, willPitch, willEx1, willEx2, willEx3, willAlg, willFb, willFms, willAms;
     bool arpMode;
     struct IntOp {
-      int amPos, arPos, drPos, multPos;
-      int rrPos, slPos, tlPos, dt2Pos;
-      int rsPos, dtPos, d2rPos, ssgPos;
-      int damPos, dvbPos, egtPos, kslPos;
-      int susPos, vibPos, wsPos, ksrPos;
-
       int am, ar, dr, mult;
       int rr, sl, tl, dt2;
       int rs, dt, d2r, ssg;
@@ -75,26 +86,6 @@ class DivMacroInt {
       bool willDam, willDvb, willEgt, willKsl;
       bool willSus, willVib, willWs, willKsr;
       IntOp():
-        amPos(0),
-        arPos(0),
-        drPos(0),
-        multPos(0),
-        rrPos(0),
-        slPos(0),
-        tlPos(0),
-        dt2Pos(0),
-        rsPos(0),
-        dtPos(0),
-        d2rPos(0),
-        ssgPos(0),
-        damPos(0),
-        dvbPos(0),
-        egtPos(0),
-        kslPos(0),
-        susPos(0),
-        vibPos(0),
-        wsPos(0),
-        ksrPos(0),
         am(0),
         ar(0),
         dr(0),
@@ -142,18 +133,7 @@ class DivMacroInt {
     void notifyInsDeletion(DivInstrument* which);
     DivMacroInt():
       ins(NULL),
-      volPos(0),
-      arpPos(0),
-      dutyPos(0),
-      wavePos(0),
-      pitchPos(0),
-      ex1Pos(0),
-      ex2Pos(0),
-      ex3Pos(0),
-      algPos(0),
-      fbPos(0),
-      fmsPos(0),
-      amsPos(0),
+      slotCount(0),
       released(false),
       vol(0),
       arp(0),
@@ -18,21 +18,84 @@
  */
 
 #include "engine.h"
+#include "../ta-log.h"
+#include <mutex>
 
 static DivPattern emptyPat;
+static std::mutex lazyLock;
 
-DivPattern::DivPattern() {
-  memset(data,-1,256*32*sizeof(short));
-  for (int i=0; i<256; i++) {
+static void clearRows(short (*data)[32], int from, int to) {
+  if (to<=from) return;
+  memset(data[from],-1,(to-from)*32*sizeof(short));
+  for (int i=from; i<to; i++) {
     data[i][0]=0;
     data[i][1]=0;
   }
 }
 
+void DivPattern::resize(int len) {
+  // a pattern length of 0 still reads the first row
+  if (len<1) len=1;
+  if (len>256) len=256;
+  if (len<=rows) return;
+  short (*newData)[32]=new short[len][32];
+  if (data!=NULL) {
+    memcpy(newData,data,rows*32*sizeof(short));
+    delete[] data;
+  }
+  clearRows(newData,rows,len);
+  data=newData;
+  rows=len;
+}
+
+DivPattern::DivPattern(int len):
+  data(NULL),
+  rows(0) {
+  resize(len);
+}
+
+DivPattern::~DivPattern() {
+  if (data!=NULL) delete[] data;
+}
+
+bool DivChannelData::hasPattern(int index) {
+  return data[index]!=NULL || lazyPtr[index]!=0;
+}
+
 DivPattern* DivChannelData::getPattern(int index, bool create) {
+  if (data[index]==NULL && lazyData!=NULL) {
+    // read the pattern if it is still in the file.
+    // this may happen from the audio thread and the GUI at the same time.
+    lazyLock.lock();
+    if (data[index]==NULL && lazyPtr[index]!=0) {
+      DivPattern* pat=new DivPattern(MAX(patLen,lazyPatLen));
+      SafeReader reader((void*)lazyData,lazyLen);
+      try {
+        reader.seek(lazyPtr[index],SEEK_SET);
+        for (int j=0; j<lazyPatLen; j++) {
+          pat->data[j][0]=reader.readS();
+          pat->data[j][1]=reader.readS();
+          pat->data[j][2]=reader.readS();
+          pat->data[j][3]=reader.readS();
+          for (int k=0; k<lazyEffectRows; k++) {
+            pat->data[j][4+(k<<1)]=reader.readS();
+            pat->data[j][5+(k<<1)]=reader.readS();
+          }
+        }
+        if (lazyVersion>=51) {
+          pat->name=reader.readString();
+        }
+      } catch (EndOfFileException e) {
+        logW("pattern %d is incomplete!\n",index);
+      }
+      data[index]=pat;
+      lazyPtr[index]=0;
+    }
+    lazyLock.unlock();
+  }
   if (data[index]==NULL) {
     if (create) {
-      data[index]=new DivPattern;
+      data[index]=new DivPattern(patLen);
     } else {
       return &emptyPat;
     }
@@ -46,19 +109,31 @@ void DivChannelData::wipePatterns() {
       delete data[i];
       data[i]=NULL;
     }
+    lazyPtr[i]=0;
+  }
+  lazyData=NULL;
+  lazyLen=0;
+}
+
+void DivChannelData::resizePatterns(int len) {
+  patLen=len;
+  for (int i=0; i<128; i++) {
+    if (data[i]!=NULL) data[i]->resize(len);
   }
 }
 
 void DivPattern::copyOn(DivPattern *dest) {
   dest->name=name;
-  memcpy(dest->data,data,sizeof(data));
+  dest->resize(rows);
+  memcpy(dest->data,data,rows*32*sizeof(short));
+  clearRows(dest->data,rows,dest->rows);
 }
 
 SafeReader* DivPattern::compile(int len, int fxRows) {
   SafeWriter w;
   w.init();
   short lastNote, lastOctave, lastInstr, lastVolume, lastEffect[8], lastEffectVal[8];
-  unsigned char rows=0;
+  unsigned char emptyRows=0;
 
   lastNote=0;
   lastOctave=0;
@@ -67,6 +142,7 @@ SafeReader* DivPattern::compile(int len, int fxRows) {
   memset(lastEffect,-1,8*sizeof(short));
   memset(lastEffectVal,-1,8*sizeof(short));
 
+  if (len>rows) len=rows;
   for (int i=0; i<len; i++) {
     unsigned char mask=0;
     if (data[i][0]!=-1) {
@@ -91,14 +167,14 @@ SafeReader* DivPattern::compile(int len, int fxRows) {
     }
 
     if (!mask) {
-      rows++;
+      emptyRows++;
       continue;
     }
 
-    if (rows!=0) {
-      w.writeC(rows);
+    if (emptyRows!=0) {
+      w.writeC(emptyRows);
     }
-    rows=1;
+    emptyRows=1;
 
     w.writeC(mask);
     if (mask&128) {
@@ -123,13 +199,20 @@ SafeReader* DivPattern::compile(int len, int fxRows) {
       }
     }
   }
-  w.writeC(rows);
+  w.writeC(emptyRows);
   w.writeC(0);
 
   return w.toReader();
 }
 
 DivChannelData::DivChannelData():
-  effectRows(1) {
+  effectRows(1),
+  patLen(256),
+  lazyData(NULL),
+  lazyLen(0),
+  lazyVersion(0),
+  lazyPatLen(0),
+  lazyEffectRows(1) {
   memset(data,0,128*sizeof(void*));
+  memset(lazyPtr,0,128*sizeof(unsigned int));
 }
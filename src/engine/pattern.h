@@ -21,10 +21,21 @@
 
 struct DivPattern {
   String name;
-  short data[256][32];
+  // only the first `rows` rows are allocated. each row takes 64 bytes.
+  short (*data)[32];
+  int rows;
+  /**
+   * make room for at least len rows (1 to 256). new rows are empty.
+   * this never shrinks the pattern.
+   */
+  void resize(int len);
   void copyOn(DivPattern* dest);
   SafeReader* compile(int len=256, int fxRows=1);
-  DivPattern();
+  DivPattern(int len=256);
+  ~DivPattern();
+  // the rows are owned by the pattern. use copyOn() to copy one.
+  DivPattern(const DivPattern&)=delete;
+  DivPattern& operator=(const DivPattern&)=delete;
 };
 
 struct DivChannelData {
@@ -37,7 +48,21 @@ struct DivChannelData {
   // 3: volume
   // 4-5+: effect/effect value
   DivPattern* data[128];
+  // number of rows which patterns in this channel are allocated with.
+  int patLen;
+  // patterns which have not been read yet when the song was loaded on demand.
+  // lazyPtr is the offset of the pattern's rows in lazyData, or 0.
+  const unsigned char* lazyData;
+  size_t lazyLen;
+  unsigned int lazyPtr[128];
+  short lazyVersion, lazyPatLen;
+  unsigned char lazyEffectRows;
+  bool hasPattern(int index);
   DivPattern* getPattern(int index, bool create);
+  /**
+   * set patLen and grow the existing patterns to it.
+   */
+  void resizePatterns(int len);
   void wipePatterns();
   DivChannelData();
 };
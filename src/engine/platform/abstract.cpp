@@ -48,6 +48,13 @@ void* DivDispatch::getState() {
 void DivDispatch::setState(void* state) {
 }
 
+void DivDispatch::freeState(void* state) {
+}
+
+bool DivDispatch::setChanTaps(short** l, short** r, int chans) {
+  return false;
+}
+
 void DivDispatch::muteChannel(int ch, bool mute) {
 }
 
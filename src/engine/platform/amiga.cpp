@@ -19,6 +19,8 @@
 
 #include "amiga.h"
 #include "../engine.h"
+#include "pcmVoice.h"
+#include <string.h>
 #include <math.h>
 
 #define AMIGA_DIVIDER 8
@@ -64,48 +66,49 @@ const char** DivPlatformAmiga::getRegisterSheet() {
 }
 
 void DivPlatformAmiga::acquire(short* bufL, short* bufR, size_t start, size_t len) {
-  for (size_t h=start; h<start+len; h++) {
-    bufL[h]=0;
-    bufR[h]=0;
+  int mixL[DIV_PCM_BLOCK];
+  int mixR[DIV_PCM_BLOCK];
+  int voice[DIV_PCM_BLOCK];
+  DivPCMSource<signed char> src;
+  while (len>0) {
+    size_t blockLen=MIN(len,DIV_PCM_BLOCK);
+    memset(mixL,0,blockLen*sizeof(int));
+    memset(mixR,0,blockLen*sizeof(int));
     for (int i=0; i<4; i++) {
-      if (chan[i].sample>=0 && chan[i].sample<parent->song.sampleLen) {
-        chan[i].audSub-=AMIGA_DIVIDER;
-        if (chan[i].audSub<0) {
-          DivSample* s=parent->getSample(chan[i].sample);
-          if (s->samples>0) {
-            chan[i].audDat=s->data8[chan[i].audPos++];
-            if (chan[i].audPos>=s->samples || chan[i].audPos>=131071) {
-              if (s->loopStart>=0 && s->loopStart<=(int)s->samples) {
-                chan[i].audPos=s->loopStart;
-              } else {
-                chan[i].sample=-1;
-              }
-            }
-          } else {
-            chan[i].sample=-1;
-          }
-          /*if (chan[i].freq<124) {
-            if (++chan[i].busClock>=512) {
-              unsigned int rAmount=(124-chan[i].freq)*2;
-              if (chan[i].audPos>=rAmount) {
-                chan[i].audPos-=rAmount;
-              }
-              chan[i].busClock=0;
-            }
-          }*/
-          chan[i].audSub+=MAX(114,chan[i].freq);
+      bool valid=(chan[i].sample>=0 && chan[i].sample<parent->song.sampleLen);
+      if (valid && src.bind(parent->getSample(chan[i].sample),131071)) {
+        bool playing;
+        if (src.loopStart>=0) {
+          playing=divPCMRenderCounter<signed char,true>(src,chan[i].audPos,chan[i].audSub,chan[i].audDat,AMIGA_DIVIDER,MAX(114,chan[i].freq),voice,blockLen);
+        } else {
+          playing=divPCMRenderCounter<signed char,false>(src,chan[i].audPos,chan[i].audSub,chan[i].audDat,AMIGA_DIVIDER,MAX(114,chan[i].freq),voice,blockLen);
         }
+        if (!playing) chan[i].sample=-1;
+      } else {
+        // the last value is held
+        if (valid) chan[i].sample=-1;
+        for (size_t h=0; h<blockLen; h++) voice[h]=chan[i].audDat;
       }
-      if (!isMuted[i]) {
-        if (i==0 || i==3) {
-          bufL[h]+=((chan[i].audDat*chan[i].outVol)*sep1)>>7;
-          bufR[h]+=((chan[i].audDat*chan[i].outVol)*sep2)>>7;
-        } else {
-          bufL[h]+=((chan[i].audDat*chan[i].outVol)*sep2)>>7;
-          bufR[h]+=((chan[i].audDat*chan[i].outVol)*sep1)>>7;
+      if (isMuted[i]) {
+        if (tapL!=NULL) {
+          memset(tapL[i]+start,0,blockLen*sizeof(short));
+          memset(tapR[i]+start,0,blockLen*sizeof(short));
         }
+        continue;
       }
+      int sepL=(i==0 || i==3)?sep1:sep2;
+      int sepR=(i==0 || i==3)?sep2:sep1;
+      divPCMMix<true>(voice,blockLen,chan[i].outVol*sepL,chan[i].outVol*sepR,7,mixL,mixR,
+        (tapL==NULL)?NULL:(tapL[i]+start),
+        (tapR==NULL)?NULL:(tapR[i]+start)
+      );
+    }
+    for (size_t h=0; h<blockLen; h++) {
+      bufL[start+h]=mixL[h];
+      bufR[start+h]=mixR[h];
     }
+    start+=blockLen;
+    len-=blockLen;
   }
 }
 
@@ -288,6 +291,13 @@ int DivPlatformAmiga::dispatch(DivCommand c) {
   return 1;
 }
 
+bool DivPlatformAmiga::setChanTaps(short** l, short** r, int chans) {
+  if (l!=NULL && chans<4) return false;
+  tapL=l;
+  tapR=r;
+  return true;
+}
+
 void DivPlatformAmiga::muteChannel(int ch, bool mute) {
   isMuted[ch]=mute;
 }
@@ -306,6 +316,18 @@ void* DivPlatformAmiga::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformAmiga::getState() {
+  return new DivPlatformAmiga(*this);
+}
+
+void DivPlatformAmiga::setState(void* state) {
+  assignState(this,(DivPlatformAmiga*)state);
+}
+
+void DivPlatformAmiga::freeState(void* state) {
+  delete (DivPlatformAmiga*)state;
+}
+
 void DivPlatformAmiga::reset() {
   for (int i=0; i<4; i++) {
     chan[i]=DivPlatformAmiga::Channel();
@@ -74,6 +74,10 @@ class DivPlatformAmiga: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
+    bool setChanTaps(short** l, short** r, int chans);
     void reset();
     void forceIns();
     void tick();
@@ -135,7 +135,7 @@ const char* DivPlatformArcade::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformArcade::acquire_nuked(short* bufL, short* bufR, size_t start, size_t len) {
-  static int o[2];
+  int o[2];
 
   for (size_t h=start; h<start+len; h++) {
     if (!writes.empty() && !fm.write_busy) {
@@ -168,33 +168,38 @@ void DivPlatformArcade::acquire_nuked(short* bufL, short* bufR, size_t start, si
 }
 
 void DivPlatformArcade::acquire_ymfm(short* bufL, short* bufR, size_t start, size_t len) {
-  static int os[2];
-
-  for (size_t h=start; h<start+len; h++) {
-    os[0]=0; os[1]=0;
-    if (!writes.empty()) {
-      if (--delay<1) {
-        QueuedWrite& w=writes.front();
-        fm_ymfm->write(0x0+((w.addr>>8)<<1),w.addr);
-        fm_ymfm->write(0x1+((w.addr>>8)<<1),w.val);
-        regPool[w.addr&0xff]=w.val;
-        writes.pop();
-        delay=1;
-      }
+  int os[2];
+  size_t h=start;
+  size_t end=start+len;
+
+  // generate in runs which end whenever a register write is due
+  while (h<end) {
+    size_t runLen=MIN(end-h,ARCADE_YMFM_BATCH);
+    if (writes.due()) {
+      QueuedWrite& w=writes.front();
+      fm_ymfm->write(0x0+((w.addr>>8)<<1),w.addr);
+      fm_ymfm->write(0x1+((w.addr>>8)<<1),w.val);
+      regPool[w.addr&0xff]=w.val;
+      writes.pop();
     }
+    // run up to the next write
+    if (!writes.empty()) runLen=MIN(runLen,(size_t)MAX(1,writes.untilNext()));
     
-    fm_ymfm->generate(&out_ymfm);
+    fm_ymfm->generate(out_ymfm,runLen);
+    writes.advance(runLen);
 
-    os[0]=out_ymfm.data[0];
-    if (os[0]<-32768) os[0]=-32768;
-    if (os[0]>32767) os[0]=32767;
+    for (size_t i=0; i<runLen; i++, h++) {
+      os[0]=out_ymfm[i].data[0];
+      if (os[0]<-32768) os[0]=-32768;
+      if (os[0]>32767) os[0]=32767;
 
-    os[1]=out_ymfm.data[1];
-    if (os[1]<-32768) os[1]=-32768;
-    if (os[1]>32767) os[1]=32767;
+      os[1]=out_ymfm[i].data[1];
+      if (os[1]<-32768) os[1]=-32768;
+      if (os[1]>32767) os[1]=32767;
   
-    bufL[h]=os[0];
-    bufR[h]=os[1];
+      bufL[h]=os[0];
+      bufR[h]=os[1];
+    }
   }
 }
 
@@ -674,6 +679,42 @@ void* DivPlatformArcade::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformArcade::getState() {
+  DivPlatformArcade* st=new DivPlatformArcade(*this);
+  st->fm_ymfm=NULL;
+  if (useYMFM) {
+    std::vector<unsigned char> coreState;
+    ymfm::ymfm_saved_state saver(coreState,true);
+    fm_ymfm->save_restore(saver);
+    st->fm_ymfm=new ymfm::ym2151(st->iface);
+    ymfm::ymfm_saved_state loader(coreState,false);
+    st->fm_ymfm->save_restore(loader);
+  }
+  return st;
+}
+
+void DivPlatformArcade::setState(void* state) {
+  DivPlatformArcade* st=(DivPlatformArcade*)state;
+  ymfm::ym2151* core=fm_ymfm;
+  DivArcadeInterface coreIface=iface;
+  assignState(this,st);
+  fm_ymfm=core;
+  iface=coreIface;
+  if (useYMFM) {
+    std::vector<unsigned char> coreState;
+    ymfm::ymfm_saved_state saver(coreState,true);
+    st->fm_ymfm->save_restore(saver);
+    ymfm::ymfm_saved_state loader(coreState,false);
+    fm_ymfm->save_restore(loader);
+  }
+}
+
+void DivPlatformArcade::freeState(void* state) {
+  DivPlatformArcade* st=(DivPlatformArcade*)state;
+  if (st->fm_ymfm!=NULL) delete st->fm_ymfm;
+  delete st;
+}
+
 unsigned char* DivPlatformArcade::getRegisterPool() {
   return regPool;
 }
@@ -691,7 +732,9 @@ void DivPlatformArcade::poke(std::vector<DivRegWrite>& wlist) {
 }
 
 void DivPlatformArcade::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
+  // ymfm takes one write per sample. Nuked-OPM waits for the busy flag.
+  writes.setSpacing(useYMFM?1:0);
   memset(regPool,0,256);
   if (useYMFM) {
     fm_ymfm->reset();
@@ -717,7 +760,6 @@ void DivPlatformArcade::reset() {
   pcmCycles=0;
   pcmL=0;
   pcmR=0;
-  delay=0;
   amDepth=0x7f;
   pmDepth=0x7f;
 
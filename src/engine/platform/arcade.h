@@ -21,11 +21,14 @@
 #define _ARCADE_H
 #include "../dispatch.h"
 #include "../instrument.h"
-#include <queue>
+#include "writeQueue.h"
 #include "../../../extern/opm/opm.h"
 #include "sound/ymfm/ymfm_opm.h"
 #include "../macroInt.h"
 
+// maximum number of samples generated by ymfm in a single call
+#define ARCADE_YMFM_BATCH 256
+
 class DivArcadeInterface: public ymfm::ymfm_interface {
 
 };
@@ -49,17 +52,18 @@ class DivPlatformArcade: public DivDispatch {
       unsigned short addr;
       unsigned char val;
       bool addrOrVal;
+      QueuedWrite(): addr(0), val(0), addrOrVal(false) {}
       QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
     };
-    std::queue<QueuedWrite> writes;
+    DivWriteQueue<QueuedWrite> writes;
     opm_t fm;
-    int delay, baseFreqOff;
+    int baseFreqOff;
     int pcmL, pcmR, pcmCycles;
     unsigned char lastBusy;
     unsigned char amDepth, pmDepth;
 
     ymfm::ym2151* fm_ymfm;
-    ymfm::ym2151::output_data out_ymfm;
+    ymfm::ym2151::output_data out_ymfm[ARCADE_YMFM_BATCH];
     DivArcadeInterface iface;
 
     unsigned char regPool[256];
@@ -83,6 +87,9 @@ class DivPlatformArcade: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
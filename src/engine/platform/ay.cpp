@@ -114,6 +114,18 @@ void DivPlatformAY8910::acquire(short* bufL, short* bufR, size_t start, size_t l
       bufR[i+start]=bufL[i+start];
     }
   }
+
+  if (tapL!=NULL && !sunsoft) {
+    for (int i=0; i<3; i++) {
+      // in stereo mode A is on the left, B on both sides and C on the right
+      bool onL=!stereo || i<2;
+      bool onR=!stereo || i>0;
+      for (size_t j=0; j<len; j++) {
+        tapL[i][j+start]=onL?ayBuf[i][j]:0;
+        tapR[i][j+start]=onR?ayBuf[i][j]:0;
+      }
+    }
+  }
 }
 
 void DivPlatformAY8910::tick() {
@@ -379,6 +391,15 @@ int DivPlatformAY8910::dispatch(DivCommand c) {
   return 1;
 }
 
+bool DivPlatformAY8910::setChanTaps(short** l, short** r, int chans) {
+  // the Sunsoft 5B mixes its channels internally
+  if (sunsoft && l!=NULL) return false;
+  if (l!=NULL && chans<3) return false;
+  tapL=l;
+  tapR=r;
+  return true;
+}
+
 void DivPlatformAY8910::muteChannel(int ch, bool mute) {
   isMuted[ch]=mute;
   if (isMuted[ch]) {
@@ -401,6 +422,34 @@ void* DivPlatformAY8910::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformAY8910::getState() {
+  DivPlatformAY8910* st=new DivPlatformAY8910(*this);
+  st->ay=new ay8910_device(*ay);
+  // the mixing buffers are not part of the state.
+  for (int i=0; i<3; i++) st->ayBuf[i]=NULL;
+  st->ayBufLen=0;
+  return st;
+}
+
+void DivPlatformAY8910::setState(void* state) {
+  DivPlatformAY8910* st=(DivPlatformAY8910*)state;
+  ay8910_device* core=ay;
+  short* keepBuf[3];
+  for (int i=0; i<3; i++) keepBuf[i]=ayBuf[i];
+  size_t keepBufLen=ayBufLen;
+  assignState(this,st);
+  ay=core;
+  *ay=*st->ay;
+  for (int i=0; i<3; i++) ayBuf[i]=keepBuf[i];
+  ayBufLen=keepBufLen;
+}
+
+void DivPlatformAY8910::freeState(void* state) {
+  DivPlatformAY8910* st=(DivPlatformAY8910*)state;
+  delete st->ay;
+  delete st;
+}
+
 unsigned char* DivPlatformAY8910::getRegisterPool() {
   return regPool;
 }
@@ -410,7 +459,7 @@ int DivPlatformAY8910::getRegisterPoolSize() {
 }
 
 void DivPlatformAY8910::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
   ay->device_reset();
   memset(regPool,0,16);
   for (int i=0; i<3; i++) {
@@ -21,7 +21,7 @@
 #define _AY_H
 #include "../dispatch.h"
 #include "../macroInt.h"
-#include <queue>
+#include "writeQueue.h"
 #include "sound/ay8910.h"
 
 class DivPlatformAY8910: public DivDispatch {
@@ -43,9 +43,10 @@ class DivPlatformAY8910: public DivDispatch {
       unsigned short addr;
       unsigned char val;
       bool addrOrVal;
+      QueuedWrite(): addr(0), val(0), addrOrVal(false) {}
       QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
     };
-    std::queue<QueuedWrite> writes;
+    DivWriteQueue<QueuedWrite> writes;
     ay8910_device* ay;
     unsigned char regPool[16];
     unsigned char lastBusy;
@@ -77,6 +78,10 @@ class DivPlatformAY8910: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
+    bool setChanTaps(short** l, short** r, int chans);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
@@ -139,6 +139,18 @@ void DivPlatformAY8930::acquire(short* bufL, short* bufR, size_t start, size_t l
       bufR[i+start]=bufL[i+start];
     }
   }
+
+  if (tapL!=NULL) {
+    for (int i=0; i<3; i++) {
+      // in stereo mode A is on the left, B on both sides and C on the right
+      bool onL=!stereo || i<2;
+      bool onR=!stereo || i>0;
+      for (size_t j=0; j<len; j++) {
+        tapL[i][j+start]=onL?ayBuf[i][j]:0;
+        tapR[i][j+start]=onR?ayBuf[i][j]:0;
+      }
+    }
+  }
 }
 
 const unsigned char regPeriodL[3]={
@@ -441,6 +453,13 @@ int DivPlatformAY8930::dispatch(DivCommand c) {
   return 1;
 }
 
+bool DivPlatformAY8930::setChanTaps(short** l, short** r, int chans) {
+  if (l!=NULL && chans<3) return false;
+  tapL=l;
+  tapR=r;
+  return true;
+}
+
 void DivPlatformAY8930::muteChannel(int ch, bool mute) {
   isMuted[ch]=mute;
   if (isMuted[ch]) {
@@ -463,6 +482,34 @@ void* DivPlatformAY8930::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformAY8930::getState() {
+  DivPlatformAY8930* st=new DivPlatformAY8930(*this);
+  st->ay=new ay8930_device(*ay);
+  // the mixing buffers are not part of the state.
+  for (int i=0; i<3; i++) st->ayBuf[i]=NULL;
+  st->ayBufLen=0;
+  return st;
+}
+
+void DivPlatformAY8930::setState(void* state) {
+  DivPlatformAY8930* st=(DivPlatformAY8930*)state;
+  ay8930_device* core=ay;
+  short* keepBuf[3];
+  for (int i=0; i<3; i++) keepBuf[i]=ayBuf[i];
+  size_t keepBufLen=ayBufLen;
+  assignState(this,st);
+  ay=core;
+  *ay=*st->ay;
+  for (int i=0; i<3; i++) ayBuf[i]=keepBuf[i];
+  ayBufLen=keepBufLen;
+}
+
+void DivPlatformAY8930::freeState(void* state) {
+  DivPlatformAY8930* st=(DivPlatformAY8930*)state;
+  delete st->ay;
+  delete st;
+}
+
 unsigned char* DivPlatformAY8930::getRegisterPool() {
   return regPool;
 }
@@ -472,7 +519,7 @@ int DivPlatformAY8930::getRegisterPoolSize() {
 }
 
 void DivPlatformAY8930::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
   ay->device_reset();
   memset(regPool,0,32);
   for (int i=0; i<3; i++) {
@@ -19,12 +19,16 @@
 
 #include "c64.h"
 #include "../engine.h"
+#include "../../ta-log.h"
 #include <math.h>
 
 #define rWrite(a,v) if (!skipRegisterWrites) {sid.write(a,v); regPool[(a)&0x1f]=v; if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_FREQBASE 524288
 
+// chip clock divider for the output rate of the reduced-rate cores
+#define C64_RESAMPLE_DIV 20
+
 const char* regCheatSheetSID[]={
   "FreqL0", "00",
   "FreqH0", "01",
@@ -109,6 +113,18 @@ const char* DivPlatformC64::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformC64::acquire(short* bufL, short* bufR, size_t start, size_t len) {
+  if (core!=DIV_C64_CORE_CYCLE) {
+    // reSID stops once it has produced the requested amount of samples,
+    // so give it more than enough cycles.
+    size_t pos=0;
+    while (pos<len) {
+      cycle_count delta=(cycle_count)((len-pos)*(C64_RESAMPLE_DIV+1)+1);
+      int got=sid.clock(delta,bufL+start+pos,len-pos);
+      if (got<1) break;
+      pos+=got;
+    }
+    return;
+  }
   for (size_t i=start; i<start+len; i++) {
     sid.clock();
     bufL[i]=sid.output();
@@ -467,6 +483,35 @@ void* DivPlatformC64::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformC64::getState() {
+  State* st=new State;
+  for (int i=0; i<3; i++) st->chan[i]=chan[i];
+  st->filtControl=filtControl;
+  st->filtRes=filtRes;
+  st->vol=vol;
+  st->filtCut=filtCut;
+  st->resetTime=resetTime;
+  memcpy(st->regPool,regPool,32);
+  st->sid=sid.read_state();
+  return st;
+}
+
+void DivPlatformC64::setState(void* state) {
+  State* st=(State*)state;
+  for (int i=0; i<3; i++) chan[i]=st->chan[i];
+  filtControl=st->filtControl;
+  filtRes=st->filtRes;
+  vol=st->vol;
+  filtCut=st->filtCut;
+  resetTime=st->resetTime;
+  memcpy(regPool,st->regPool,32);
+  sid.write_state(st->sid);
+}
+
+void DivPlatformC64::freeState(void* state) {
+  delete (State*)state;
+}
+
 unsigned char* DivPlatformC64::getRegisterPool() {
   return regPool;
 }
@@ -508,6 +553,10 @@ void DivPlatformC64::setChipModel(bool is6581) {
   }
 }
 
+void DivPlatformC64::setCore(DivC64Cores c) {
+  core=c;
+}
+
 void DivPlatformC64::setFlags(unsigned int flags) {
   if (flags&1) {
     rate=COLOR_PAL*2.0/9.0;
@@ -515,6 +564,21 @@ void DivPlatformC64::setFlags(unsigned int flags) {
     rate=COLOR_NTSC*2.0/7.0;
   }
   chipClock=rate;
+  switch (core) {
+    case DIV_C64_CORE_INTERPOLATE:
+      rate=chipClock/C64_RESAMPLE_DIV;
+      sid.set_sampling_parameters(chipClock,SAMPLE_INTERPOLATE,rate);
+      break;
+    case DIV_C64_CORE_RESAMPLE:
+      rate=chipClock/C64_RESAMPLE_DIV;
+      if (!sid.set_sampling_parameters(chipClock,SAMPLE_RESAMPLE_INTERPOLATE,rate)) {
+        logW("could not set up reSID resampling! falling back to interpolation.\n");
+        sid.set_sampling_parameters(chipClock,SAMPLE_INTERPOLATE,rate);
+      }
+      break;
+    default:
+      break;
+  }
 }
 
 int DivPlatformC64::init(DivEngine* p, int channels, int sugRate, unsigned int flags) {
@@ -24,6 +24,15 @@
 #include "../macroInt.h"
 #include "sound/c64/sid.h"
 
+enum DivC64Cores {
+  // clocks reSID once per output sample at the full chip rate
+  DIV_C64_CORE_CYCLE=0,
+  // lets reSID produce output at a reduced rate (see C64_RESAMPLE_DIV)
+  DIV_C64_CORE_INTERPOLATE,
+  DIV_C64_CORE_RESAMPLE,
+  DIV_C64_CORE_E
+};
+
 class DivPlatformC64: public DivDispatch {
   struct Channel {
     int freq, baseFreq, pitch, prevFreq, testWhen, note;
@@ -69,9 +78,19 @@ class DivPlatformC64: public DivDispatch {
   unsigned char filtControl, filtRes, vol;
   int filtCut, resetTime;
 
+  DivC64Cores core;
   SID sid;
   unsigned char regPool[32];
 
+  // reSID owns its resampling buffers, so this is stored instead of a copy of the whole dispatch.
+  struct State {
+    Channel chan[3];
+    unsigned char filtControl, filtRes, vol;
+    int filtCut, resetTime;
+    unsigned char regPool[32];
+    SID::State sid;
+  };
+
   friend void putDispatchChan(void*,int,int);
 
   void updateFilter();
@@ -79,6 +98,9 @@ class DivPlatformC64: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
@@ -94,6 +116,7 @@ class DivPlatformC64: public DivDispatch {
     const char* getEffectName(unsigned char effect);
     int init(DivEngine* parent, int channels, int sugRate, unsigned int flags);
     void setChipModel(bool is6581);
+    void setCore(DivC64Cores core);
     void quit();
     ~DivPlatformC64();
 };
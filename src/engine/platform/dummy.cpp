@@ -54,6 +54,18 @@ void* DivPlatformDummy::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformDummy::getState() {
+  return new DivPlatformDummy(*this);
+}
+
+void DivPlatformDummy::setState(void* state) {
+  assignState(this,(DivPlatformDummy*)state);
+}
+
+void DivPlatformDummy::freeState(void* state) {
+  delete (DivPlatformDummy*)state;
+}
+
 int DivPlatformDummy::dispatch(DivCommand c) {
   switch (c.cmd) {
     case DIV_CMD_NOTE_ON:
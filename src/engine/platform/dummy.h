@@ -40,6 +40,9 @@ class DivPlatformDummy: public DivDispatch {
     void muteChannel(int ch, bool mute);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     void reset();
     void tick();
     int init(DivEngine* parent, int channels, int sugRate, unsigned int flags);
@@ -83,11 +83,7 @@ const char* DivPlatformGB::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformGB::acquire(short* bufL, short* bufR, size_t start, size_t len) {
-  for (size_t i=start; i<start+len; i++) {
-    GB_advance_cycles(gb,16);
-    bufL[i]=gb->apu_output.final_sample.left;
-    bufR[i]=gb->apu_output.final_sample.right;
-  }
+  GB_advance_cycles_batch(gb,16,bufL+start,bufR+start,len);
 }
 
 void DivPlatformGB::updateWave() {
@@ -395,6 +391,27 @@ void* DivPlatformGB::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformGB::getState() {
+  DivPlatformGB* st=new DivPlatformGB(*this);
+  st->gb=new GB_gameboy_t;
+  *st->gb=*gb;
+  return st;
+}
+
+void DivPlatformGB::setState(void* state) {
+  DivPlatformGB* st=(DivPlatformGB*)state;
+  GB_gameboy_t* core=gb;
+  assignState(this,st);
+  gb=core;
+  *gb=*st->gb;
+}
+
+void DivPlatformGB::freeState(void* state) {
+  DivPlatformGB* st=(DivPlatformGB*)state;
+  delete st->gb;
+  delete st;
+}
+
 unsigned char* DivPlatformGB::getRegisterPool() {
   return regPool;
 }
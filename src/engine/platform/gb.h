@@ -64,6 +64,9 @@ class DivPlatformGB: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
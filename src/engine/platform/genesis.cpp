@@ -19,6 +19,7 @@
 
 #include "genesis.h"
 #include "../engine.h"
+#include "pcmVoice.h"
 #include <string.h>
 #include <math.h>
 
@@ -82,29 +83,25 @@ const char* DivPlatformGenesis::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformGenesis::acquire_nuked(short* bufL, short* bufR, size_t start, size_t len) {
-  static short o[2];
-  static int os[2];
+  DivPCMSource<signed char> dac;
+  if (dacMode && dacSample!=-1 && !dac.bind(parent->getSample(dacSample))) {
+    dacSample=-1;
+  }
+
+  short o[2];
+  int os[2];
 
   for (size_t h=start; h<start+len; h++) {
     if (dacMode && dacSample!=-1) {
       dacPeriod-=6;
       if (dacPeriod<1) {
-        DivSample* s=parent->getSample(dacSample);
-        if (s->samples>0) {
-          if (!isMuted[5]) {
-            immWrite(0x2a,(unsigned char)s->data8[dacPos]+0x80);
-          }
-          if (++dacPos>=s->samples) {
-            if (s->loopStart>=0 && s->loopStart<=(int)s->samples) {
-              dacPos=s->loopStart;
-            } else {
-              dacSample=-1;
-            }
-          }
-          dacPeriod+=MAX(40,dacRate);
-        } else {
+        if (!isMuted[5]) {
+          immWrite(0x2a,(unsigned char)dac.data[dacPos]+0x80);
+        }
+        if (!dac.advance(dacPos)) {
           dacSample=-1;
         }
+        dacPeriod+=MAX(40,dacRate);
       }
     }
   
@@ -147,33 +144,37 @@ void DivPlatformGenesis::acquire_nuked(short* bufL, short* bufR, size_t start, s
 }
 
 void DivPlatformGenesis::acquire_ymfm(short* bufL, short* bufR, size_t start, size_t len) {
-  static int os[2];
+  DivPCMSource<signed char> dac;
+  if (dacMode && dacSample!=-1 && !dac.bind(parent->getSample(dacSample))) {
+    dacSample=-1;
+  }
 
-  for (size_t h=start; h<start+len; h++) {
-    if (dacMode && dacSample!=-1) {
-      dacPeriod-=24;
-      if (dacPeriod<1) {
-        DivSample* s=parent->getSample(dacSample);
-        if (s->samples>0) {
-          if (!isMuted[5]) {
-            immWrite(0x2a,(unsigned char)s->data8[dacPos]+0x80);
-          }
-          if (++dacPos>=s->samples) {
-            if (s->loopStart>=0 && s->loopStart<=(int)s->samples) {
-              dacPos=s->loopStart;
-            } else {
-              dacSample=-1;
-            }
-          }
-          dacPeriod+=MAX(40,dacRate);
-        } else {
+  int os[2];
+  size_t h=start;
+  size_t end=start+len;
+
+  // generate in runs which end whenever a register write is due
+  while (h<end) {
+    size_t runLen=MIN(end-h,GENESIS_YMFM_BATCH);
+    bool dacRunning=(dacMode && dacSample!=-1);
+
+    if (dacRunning) {
+      if (dacPeriod>24) {
+        // no DAC write until the period runs out
+        runLen=MIN(runLen,(size_t)((dacPeriod-1)/24));
+      } else {
+        runLen=1;
+        if (!isMuted[5]) {
+          immWrite(0x2a,(unsigned char)dac.data[dacPos]+0x80);
+        }
+        if (!dac.advance(dacPos)) {
           dacSample=-1;
         }
+        dacPeriod+=MAX(40,dacRate);
       }
     }
-  
-    os[0]=0; os[1]=0;
-    if (!writes.empty()) {
+
+    if (writes.due()) {
       QueuedWrite& w=writes.front();
       fm_ymfm->write(0x0+((w.addr>>8)<<1),w.addr);
       fm_ymfm->write(0x1+((w.addr>>8)<<1),w.val);
@@ -181,24 +182,30 @@ void DivPlatformGenesis::acquire_ymfm(short* bufL, short* bufR, size_t start, si
       writes.pop();
       lastBusy=1;
     }
+    // run up to the next write
+    if (!writes.empty()) runLen=MIN(runLen,(size_t)MAX(1,writes.untilNext()));
+    if (dacRunning) dacPeriod-=24*(int)runLen;
     
     if (ladder) {
-      fm_ymfm->generate(&out_ymfm);
+      fm_ymfm->generate(out_ymfm,runLen);
     } else {
-      ((ymfm::ym3438*)fm_ymfm)->generate(&out_ymfm);
+      ((ymfm::ym3438*)fm_ymfm)->generate(out_ymfm,runLen);
     }
-    os[0]=out_ymfm.data[0];
-    os[1]=out_ymfm.data[1];
-    //OPN2_Write(&fm,0,0);
+    writes.advance(runLen);
+
+    for (size_t i=0; i<runLen; i++, h++) {
+      os[0]=out_ymfm[i].data[0];
+      os[1]=out_ymfm[i].data[1];
     
-    if (os[0]<-32768) os[0]=-32768;
-    if (os[0]>32767) os[0]=32767;
+      if (os[0]<-32768) os[0]=-32768;
+      if (os[0]>32767) os[0]=32767;
 
-    if (os[1]<-32768) os[1]=-32768;
-    if (os[1]>32767) os[1]=32767;
+      if (os[1]<-32768) os[1]=-32768;
+      if (os[1]>32767) os[1]=32767;
   
-    bufL[h]=os[0];
-    bufR[h]=os[1];
+      bufL[h]=os[0];
+      bufR[h]=os[1];
+    }
   }
 }
 
@@ -761,6 +768,48 @@ void* DivPlatformGenesis::getChanState(int ch) {
   return &chan[ch];
 }
 
+void DivPlatformGenesis::cloneCore(DivPlatformGenesis* st) {
+  st->fm_ymfm=NULL;
+  if (fm_ymfm==NULL) return;
+  std::vector<unsigned char> coreState;
+  ymfm::ymfm_saved_state saver(coreState,true);
+  fm_ymfm->save_restore(saver);
+  st->fm_ymfm=new ymfm::ym2612(st->iface);
+  ymfm::ymfm_saved_state loader(coreState,false);
+  st->fm_ymfm->save_restore(loader);
+}
+
+void DivPlatformGenesis::restoreCore(DivPlatformGenesis* st, ymfm::ym2612* core, const DivYM2612Interface& coreIface) {
+  fm_ymfm=core;
+  iface=coreIface;
+  if (fm_ymfm==NULL || st->fm_ymfm==NULL) return;
+  std::vector<unsigned char> coreState;
+  ymfm::ymfm_saved_state saver(coreState,true);
+  st->fm_ymfm->save_restore(saver);
+  ymfm::ymfm_saved_state loader(coreState,false);
+  fm_ymfm->save_restore(loader);
+}
+
+void* DivPlatformGenesis::getState() {
+  DivPlatformGenesis* st=new DivPlatformGenesis(*this);
+  cloneCore(st);
+  return st;
+}
+
+void DivPlatformGenesis::setState(void* state) {
+  DivPlatformGenesis* st=(DivPlatformGenesis*)state;
+  ymfm::ym2612* core=fm_ymfm;
+  DivYM2612Interface coreIface=iface;
+  assignState(this,st);
+  restoreCore(st,core,coreIface);
+}
+
+void DivPlatformGenesis::freeState(void* state) {
+  DivPlatformGenesis* st=(DivPlatformGenesis*)state;
+  if (st->fm_ymfm!=NULL) delete st->fm_ymfm;
+  delete st;
+}
+
 unsigned char* DivPlatformGenesis::getRegisterPool() {
   return regPool;
 }
@@ -770,7 +819,9 @@ int DivPlatformGenesis::getRegisterPoolSize() {
 }
 
 void DivPlatformGenesis::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
+  // ymfm takes one write per sample. Nuked-OPN2 paces writes itself.
+  writes.setSpacing(useYMFM?1:0);
   memset(regPool,0,512);
   if (useYMFM) {
     fm_ymfm->reset();
@@ -20,12 +20,15 @@
 #ifndef _GENESIS_H
 #define _GENESIS_H
 #include "../dispatch.h"
-#include <queue>
+#include "writeQueue.h"
 #include "../../../extern/Nuked-OPN2/ym3438.h"
 #include "sound/ymfm/ymfm_opn.h"
 
 #include "sms.h"
 
+// maximum number of samples generated by ymfm in a single call
+#define GENESIS_YMFM_BATCH 256
+
 class DivYM2612Interface: public ymfm::ymfm_interface {
 
 };
@@ -66,15 +69,16 @@ class DivPlatformGenesis: public DivDispatch {
       unsigned short addr;
       unsigned char val;
       bool addrOrVal;
+      QueuedWrite(): addr(0), val(0), addrOrVal(false) {}
       QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
     };
-    std::queue<QueuedWrite> writes;
+    DivWriteQueue<QueuedWrite> writes;
     ym3438_t fm;
     int delay;
     unsigned char lastBusy;
 
     ymfm::ym2612* fm_ymfm;
-    ymfm::ym2612::output_data out_ymfm;
+    ymfm::ym2612::output_data out_ymfm[GENESIS_YMFM_BATCH];
     DivYM2612Interface iface;
     unsigned char regPool[512];
   
@@ -99,11 +103,17 @@ class DivPlatformGenesis: public DivDispatch {
 
     void acquire_nuked(short* bufL, short* bufR, size_t start, size_t len);
     void acquire_ymfm(short* bufL, short* bufR, size_t start, size_t len);
+
+    void cloneCore(DivPlatformGenesis* st);
+    void restoreCore(DivPlatformGenesis* st, ymfm::ym2612* core, const DivYM2612Interface& coreIface);
   
   public:
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
@@ -323,6 +323,26 @@ void* DivPlatformGenesisExt::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformGenesisExt::getState() {
+  DivPlatformGenesisExt* st=new DivPlatformGenesisExt(*this);
+  cloneCore(st);
+  return st;
+}
+
+void DivPlatformGenesisExt::setState(void* state) {
+  DivPlatformGenesisExt* st=(DivPlatformGenesisExt*)state;
+  ymfm::ym2612* core=fm_ymfm;
+  DivYM2612Interface coreIface=iface;
+  assignState(this,st);
+  restoreCore(st,core,coreIface);
+}
+
+void DivPlatformGenesisExt::freeState(void* state) {
+  DivPlatformGenesisExt* st=(DivPlatformGenesisExt*)state;
+  if (st->fm_ymfm!=NULL) delete st->fm_ymfm;
+  delete st;
+}
+
 void DivPlatformGenesisExt::reset() {
   DivPlatformGenesis::reset();
 
@@ -281,6 +281,25 @@ void* DivPlatformLynx::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformLynx::getState() {
+  State* st=new State;
+  for (int i=0; i<4; i++) st->chan[i]=chan[i];
+  st->mikey=new Lynx::Mikey(*mikey);
+  return st;
+}
+
+void DivPlatformLynx::setState(void* state) {
+  State* st=(State*)state;
+  for (int i=0; i<4; i++) chan[i]=st->chan[i];
+  *mikey=*st->mikey;
+}
+
+void DivPlatformLynx::freeState(void* state) {
+  State* st=(State*)state;
+  delete st->mikey;
+  delete st;
+}
+
 unsigned char* DivPlatformLynx::getRegisterPool()
 {
   return const_cast<unsigned char*>( mikey->getRegisterPool() );
@@ -20,6 +20,7 @@
 #include "nes.h"
 #include "sound/nes/cpu_inline.h"
 #include "../engine.h"
+#include "pcmVoice.h"
 #include <cstddef>
 #include <math.h>
 
@@ -70,36 +71,66 @@ const char* DivPlatformNES::getEffectName(unsigned char effect) {
   return NULL;
 }
 
+// runs the APU for the given amount of cycles and returns the sum of the output.
+// cycles in which only the timers count down are skipped over in one go.
+int DivPlatformNES::runAPU(int cycles) {
+  int acc=0;
+  while (cycles>0) {
+    int out=pulse_output(nes)+tnd_output(nes);
+    int idle=apu_idle_cycles(nes);
+    if (idle>0) {
+      if (idle>cycles) idle=cycles;
+      apu_skip(nes,idle);
+      if (idle&1) nes->apu.odd_cycle=!nes->apu.odd_cycle;
+      acc+=out*idle;
+      cycles-=idle;
+      continue;
+    }
+    apu_tick(nes,NULL);
+    nes->apu.odd_cycle=!nes->apu.odd_cycle;
+    if (nes->apu.clocked) {
+      nes->apu.clocked=false;
+    }
+    acc+=pulse_output(nes)+tnd_output(nes);
+    cycles--;
+  }
+  return acc;
+}
+
 void DivPlatformNES::acquire(short* bufL, short* bufR, size_t start, size_t len) {
+  DivPCMSource<signed char> dac;
+  if (dacSample!=-1 && !dac.bind(parent->getSample(dacSample))) {
+    dacSample=-1;
+  }
+
   for (size_t i=start; i<start+len; i++) {
-    if (dacSample!=-1) {
-      dacPeriod+=dacRate;
-      if (dacPeriod>=rate) {
-        DivSample* s=parent->getSample(dacSample);
-        if (s->samples>0) {
+    // each output sample is the average of rateDiv APU cycles.
+    // the run is split at DAC writes so these land on the right cycle.
+    int acc=0;
+    int left=rateDiv;
+    while (left>0) {
+      int run=left;
+      if (dacSample!=-1) {
+        if (dacRate<=0 || dacPeriod+dacRate<chipClock) {
+          if (dacRate>0) run=MIN(run,(chipClock-1-dacPeriod)/dacRate);
+          dacPeriod+=dacRate*run;
+        } else {
+          run=1;
+          dacPeriod+=dacRate;
           if (!isMuted[4]) {
-            rWrite(0x4011,((unsigned char)s->data8[dacPos]+0x80)>>1);
+            rWrite(0x4011,((unsigned char)dac.data[dacPos]+0x80)>>1);
           }
-          if (++dacPos>=s->samples) {
-            if (s->loopStart>=0 && s->loopStart<=(int)s->samples) {
-              dacPos=s->loopStart;
-            } else {
-              dacSample=-1;
-            }
+          if (!dac.advance(dacPos)) {
+            dacSample=-1;
           }
-          dacPeriod-=rate;
-        } else {
-          dacSample=-1;
+          dacPeriod-=chipClock;
         }
       }
+      acc+=runAPU(run);
+      left-=run;
     }
-  
-    apu_tick(nes,NULL);
-    nes->apu.odd_cycle=!nes->apu.odd_cycle;
-    if (nes->apu.clocked) {
-      nes->apu.clocked=false;
-    }
-    int sample=(pulse_output(nes)+tnd_output(nes)-128)<<7;
+
+    int sample=((acc/rateDiv)-128)<<7;
     if (sample>32767) sample=32767;
     if (sample<-32768) sample=-32768;
     bufL[i]=sample;
@@ -443,6 +474,27 @@ void* DivPlatformNES::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformNES::getState() {
+  DivPlatformNES* st=new DivPlatformNES(*this);
+  st->nes=new struct NESAPU;
+  *st->nes=*nes;
+  return st;
+}
+
+void DivPlatformNES::setState(void* state) {
+  DivPlatformNES* st=(DivPlatformNES*)state;
+  struct NESAPU* core=nes;
+  assignState(this,st);
+  nes=core;
+  *nes=*st->nes;
+}
+
+void DivPlatformNES::freeState(void* state) {
+  DivPlatformNES* st=(DivPlatformNES*)state;
+  delete st->nes;
+  delete st;
+}
+
 unsigned char* DivPlatformNES::getRegisterPool() {
   return regPool;
 }
@@ -494,6 +546,11 @@ void DivPlatformNES::setFlags(unsigned int flags) {
     nes->apu.type=apuType;
   }
   chipClock=rate;
+  rate/=rateDiv;
+}
+
+void DivPlatformNES::setRateDivider(int div) {
+  rateDiv=MAX(1,div);
 }
 
 void DivPlatformNES::notifyInsDeletion(void* ins) {
@@ -58,15 +58,22 @@ class DivPlatformNES: public DivDispatch {
   int dacSample;
   unsigned char sampleBank;
   unsigned char apuType;
+  // APU cycles per output sample
+  int rateDiv;
   struct NESAPU* nes;
   unsigned char regPool[128];
 
   friend void putDispatchChan(void*,int,int);
 
+  int runAPU(int cycles);
+
   public:
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
@@ -75,6 +82,7 @@ class DivPlatformNES: public DivDispatch {
     void muteChannel(int ch, bool mute);
     bool keyOffAffectsArp(int ch);
     void setFlags(unsigned int flags);
+    void setRateDivider(int div);
     void notifyInsDeletion(void* ins);
     void poke(unsigned int addr, unsigned short val);
     void poke(std::vector<DivRegWrite>& wlist);
@@ -187,29 +187,37 @@ const char* DivPlatformOPL::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformOPL::acquire_nuked(short* bufL, short* bufR, size_t start, size_t len) {
-  static short o[2];
-  static int os[2];
+  short o[2];
+  int os[2];
 
-  for (size_t h=start; h<start+len; h++) {
-    os[0]=0; os[1]=0;
-    if (!writes.empty() && --delay<0) {
-      delay=1;
+  size_t h=start;
+  size_t end=start+len;
+
+  // generate in runs which end whenever a register write is due
+  while (h<end) {
+    size_t runLen=end-h;
+    if (writes.due()) {
       QueuedWrite& w=writes.front();
       OPL3_WriteReg(&fm,w.addr,w.val);
       regPool[w.addr&511]=w.val;
       writes.pop();
     }
+    if (!writes.empty()) runLen=MIN(runLen,(size_t)MAX(1,writes.untilNext()));
+
+    for (size_t i=0; i<runLen; i++, h++) {
+      os[0]=0; os[1]=0;
+      OPL3_Generate(&fm,o); os[0]+=o[0]; os[1]+=o[1];
     
-    OPL3_Generate(&fm,o); os[0]+=o[0]; os[1]+=o[1];
-    
-    if (os[0]<-32768) os[0]=-32768;
-    if (os[0]>32767) os[0]=32767;
+      if (os[0]<-32768) os[0]=-32768;
+      if (os[0]>32767) os[0]=32767;
 
-    if (os[1]<-32768) os[1]=-32768;
-    if (os[1]>32767) os[1]=32767;
+      if (os[1]<-32768) os[1]=-32768;
+      if (os[1]>32767) os[1]=32767;
   
-    bufL[h]=os[0];
-    bufR[h]=os[1];
+      bufL[h]=os[0];
+      bufR[h]=os[1];
+    }
+    writes.advance(runLen);
   }
 }
 
@@ -735,7 +743,8 @@ int DivPlatformOPL::getRegisterPoolSize() {
 }
 
 void DivPlatformOPL::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
+  writes.setSpacing(2);
   memset(regPool,0,512);
   /*
   if (useYMFM) {
@@ -765,7 +774,6 @@ void DivPlatformOPL::reset() {
     immWrite(0x105,1);
   }
   
-  delay=0;
 }
 
 bool DivPlatformOPL::isStereo() {
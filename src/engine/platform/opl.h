@@ -21,7 +21,7 @@
 #define _OPL_H
 #include "../dispatch.h"
 #include "../macroInt.h"
-#include <queue>
+#include "writeQueue.h"
 #include "../../../extern/Nuked-OPL3/opl3.h"
 
 class DivPlatformOPL: public DivDispatch {
@@ -60,16 +60,17 @@ class DivPlatformOPL: public DivDispatch {
       unsigned short addr;
       unsigned char val;
       bool addrOrVal;
+      QueuedWrite(): addr(0), val(0), addrOrVal(false) {}
       QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
     };
-    std::queue<QueuedWrite> writes;
+    DivWriteQueue<QueuedWrite> writes;
     opl3_chip fm;
     const unsigned char** slotsNonDrums;
     const unsigned char** slotsDrums;
     const unsigned char** slots;
     const unsigned short* chanMap;
     double chipFreqBase;
-    int delay, oplType;
+    int oplType;
     unsigned char lastBusy;
 
     unsigned char regPool[512];
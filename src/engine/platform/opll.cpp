@@ -68,8 +68,8 @@ const unsigned char drumSlot[11]={
 };
 
 void DivPlatformOPLL::acquire_nuked(short* bufL, short* bufR, size_t start, size_t len) {
-  static int o[2];
-  static int os;
+  int o[2];
+  int os;
 
   for (size_t h=start; h<start+len; h++) {
     os=0;
@@ -701,6 +701,18 @@ void* DivPlatformOPLL::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformOPLL::getState() {
+  return new DivPlatformOPLL(*this);
+}
+
+void DivPlatformOPLL::setState(void* state) {
+  assignState(this,(DivPlatformOPLL*)state);
+}
+
+void DivPlatformOPLL::freeState(void* state) {
+  delete (DivPlatformOPLL*)state;
+}
+
 unsigned char* DivPlatformOPLL::getRegisterPool() {
   return regPool;
 }
@@ -710,7 +722,7 @@ int DivPlatformOPLL::getRegisterPoolSize() {
 }
 
 void DivPlatformOPLL::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
   memset(regPool,0,256);
   if (vrc7) {
     OPLL_Reset(&fm,opll_type_ds1001);
@@ -21,7 +21,7 @@
 #define _OPLL_H
 #include "../dispatch.h"
 #include "../macroInt.h"
-#include <queue>
+#include "writeQueue.h"
 
 extern "C" {
 #include "../../../extern/Nuked-OPLL/opll.h"
@@ -63,9 +63,10 @@ class DivPlatformOPLL: public DivDispatch {
       unsigned short addr;
       unsigned char val;
       bool addrOrVal;
+      QueuedWrite(): addr(0), val(0), addrOrVal(false) {}
       QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
     };
-    std::queue<QueuedWrite> writes;
+    DivWriteQueue<QueuedWrite> writes;
     opll_t fm;
     int delay, lastCustomMemory;
     unsigned char lastBusy;
@@ -96,6 +97,9 @@ class DivPlatformOPLL: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
@@ -19,6 +19,7 @@
 
 #include "pce.h"
 #include "../engine.h"
+#include "pcmVoice.h"
 #include <math.h>
 
 //#define rWrite(a,v) pendingWrites[a]=v;
@@ -75,27 +76,28 @@ const char* DivPlatformPCE::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformPCE::acquire(short* bufL, short* bufR, size_t start, size_t len) {
+  DivPCMSource<signed char> dac[6];
+  bool dacActive[6];
+  for (int i=0; i<6; i++) {
+    dacActive[i]=false;
+    if (chan[i].pcm && chan[i].dacSample!=-1) {
+      dacActive[i]=dac[i].bind(parent->getSample(chan[i].dacSample));
+      if (!dacActive[i]) chan[i].dacSample=-1;
+    }
+  }
+
   for (size_t h=start; h<start+len; h++) {
     // PCM part
     for (int i=0; i<6; i++) {
-      if (chan[i].pcm && chan[i].dacSample!=-1) {
+      if (dacActive[i]) {
         chan[i].dacPeriod+=chan[i].dacRate;
         if (chan[i].dacPeriod>rate) {
-          DivSample* s=parent->getSample(chan[i].dacSample);
-          if (s->samples<=0) {
-            chan[i].dacSample=-1;
-            continue;
-          }
           chWrite(i,0x07,0);
           chWrite(i,0x04,0xdf);
-          chWrite(i,0x06,(((unsigned char)s->data8[chan[i].dacPos]+0x80)>>3));
-          chan[i].dacPos++;
-          if (chan[i].dacPos>=s->samples) {
-            if (s->loopStart>=0 && s->loopStart<=(int)s->samples) {
-              chan[i].dacPos=s->loopStart;
-            } else {
-              chan[i].dacSample=-1;
-            }
+          chWrite(i,0x06,(((unsigned char)dac[i].data[chan[i].dacPos]+0x80)>>3));
+          if (!dac[i].advance(chan[i].dacPos)) {
+            chan[i].dacSample=-1;
+            dacActive[i]=false;
           }
           chan[i].dacPeriod-=rate;
         }
@@ -113,9 +115,17 @@ void DivPlatformPCE::acquire(short* bufL, short* bufR, size_t start, size_t len)
     }
     memset(tempL,0,24*sizeof(int));
     memset(tempR,0,24*sizeof(int));
+    if (tapL!=NULL) memset(tapTemp,0,sizeof(tapTemp));
     pce->Update(24);
     pce->ResetTS(0);
 
+    if (tapL!=NULL) for (int i=0; i<6; i++) {
+      int outL=(tapTemp[i][0][0]>>1)+(tapTemp[i][0][0]>>2);
+      int outR=(tapTemp[i][1][0]>>1)+(tapTemp[i][1][0]>>2);
+      tapL[i][h]=MAX(-32768,MIN(32767,outL));
+      tapR[i][h]=MAX(-32768,MIN(32767,outR));
+    }
+
     tempL[0]=(tempL[0]>>1)+(tempL[0]>>2);
     tempR[0]=(tempR[0]>>1)+(tempR[0]>>2);
 
@@ -428,6 +438,20 @@ int DivPlatformPCE::dispatch(DivCommand c) {
   return 1;
 }
 
+bool DivPlatformPCE::setChanTaps(short** l, short** r, int chans) {
+  if (l!=NULL && chans<6) return false;
+  tapL=l;
+  tapR=r;
+  for (int i=0; i<6; i++) {
+    if (l==NULL) {
+      pce->SetChanHRBufs(i,NULL,NULL);
+    } else {
+      pce->SetChanHRBufs(i,tapTemp[i][0],tapTemp[i][1]);
+    }
+  }
+  return true;
+}
+
 void DivPlatformPCE::muteChannel(int ch, bool mute) {
   isMuted[ch]=mute;
   chWrite(ch,0x05,isMuted[ch]?0:chan[ch].pan);
@@ -446,6 +470,26 @@ void* DivPlatformPCE::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformPCE::getState() {
+  DivPlatformPCE* st=new DivPlatformPCE(*this);
+  st->pce=new PCE_PSG(*pce);
+  return st;
+}
+
+void DivPlatformPCE::setState(void* state) {
+  DivPlatformPCE* st=(DivPlatformPCE*)state;
+  PCE_PSG* core=pce;
+  assignState(this,st);
+  pce=core;
+  *pce=*st->pce;
+}
+
+void DivPlatformPCE::freeState(void* state) {
+  DivPlatformPCE* st=(DivPlatformPCE*)state;
+  delete st->pce;
+  delete st;
+}
+
 unsigned char* DivPlatformPCE::getRegisterPool() {
   return regPool;
 }
@@ -455,7 +499,7 @@ int DivPlatformPCE::getRegisterPoolSize() {
 }
 
 void DivPlatformPCE::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
   memset(regPool,0,128);
   for (int i=0; i<6; i++) {
     chan[i]=DivPlatformPCE::Channel();
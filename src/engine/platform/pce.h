@@ -21,7 +21,7 @@
 #define _PCE_H
 
 #include "../dispatch.h"
-#include <queue>
+#include "writeQueue.h"
 #include "../macroInt.h"
 #include "sound/pce_psg.h"
 
@@ -64,14 +64,16 @@ class DivPlatformPCE: public DivDispatch {
   struct QueuedWrite {
       unsigned char addr;
       unsigned char val;
+      QueuedWrite(): addr(0), val(0) {}
       QueuedWrite(unsigned char a, unsigned char v): addr(a), val(v) {}
   };
-  std::queue<QueuedWrite> writes;
+  DivWriteQueue<QueuedWrite> writes;
   unsigned char lastPan;
 
   int cycles, curChan, delay;
   int tempL[32];
   int tempR[32];
+  int tapTemp[6][2][32];
   unsigned char sampleBank, lfoMode, lfoSpeed;
   PCE_PSG* pce;
   unsigned char regPool[128];
@@ -81,6 +83,10 @@ class DivPlatformPCE: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
+    bool setChanTaps(short** l, short** r, int chans);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
@@ -0,0 +1,166 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _PCMVOICE_H
+#define _PCMVOICE_H
+#include "../engine.h"
+#include <stddef.h>
+
+// maximum number of output samples rendered at once by the block helpers.
+#define DIV_PCM_BLOCK 256
+
+template<typename T> inline const T* divPCMData(DivSample* s);
+
+template<> inline const signed char* divPCMData<signed char>(DivSample* s) {
+  return s->data8;
+}
+
+template<> inline const short* divPCMData<short>(DivSample* s) {
+  return s->data16;
+}
+
+/**
+ * sample data, end and loop point of a voice.
+ * these are fetched once per block instead of once per output sample.
+ */
+template<typename T> struct DivPCMSource {
+  const T* data;
+  unsigned int end;
+  // -1 if the sample does not loop.
+  int loopStart;
+
+  /**
+   * bind a sample.
+   * @param s the sample.
+   * @param limit the maximum length the voice can address, or 0 for no limit.
+   * @return whether the sample can be played.
+   */
+  bool bind(DivSample* s, unsigned int limit=0) {
+    data=divPCMData<T>(s);
+    if (data==NULL || s->samples<=0) return false;
+    end=s->samples;
+    if (limit>0 && end>limit) end=limit;
+    loopStart=(s->loopStart>=0 && s->loopStart<=(int)s->samples)?s->loopStart:-1;
+    return true;
+  }
+
+  /**
+   * move to the next sample, going back to the loop point at the end.
+   * @return false if the sample ended.
+   */
+  template<typename P> inline bool advance(P& pos) const {
+    if ((unsigned int)(++pos)>=end) {
+      if (loopStart<0) return false;
+      pos=loopStart;
+    }
+    return true;
+  }
+
+  DivPCMSource():
+    data(NULL),
+    end(0),
+    loopStart(-1) {}
+};
+
+/**
+ * render a voice which reads the sample at a fixed-point position moving by
+ * freq every output sample (e.g. SegaPCM).
+ * @param pos the position, with shift fractional bits.
+ * @return false if the sample ended. the rest of out is filled with zeros.
+ */
+template<typename T, bool loop, int shift> bool divPCMRenderPhase(const DivPCMSource<T>& src, unsigned int& pos, unsigned int freq, int* out, size_t len) {
+  const unsigned int end=src.end<<shift;
+  size_t i=0;
+  while (i<len) {
+    // run up to the end of the sample without checking it
+    size_t run=len-i;
+    if (pos>=end) {
+      run=1;
+    } else if (freq>0) {
+      size_t toEnd=(end-pos+freq-1)/freq;
+      if (toEnd<run) run=toEnd;
+    }
+    for (size_t j=0; j<run; j++) {
+      out[i++]=src.data[pos>>shift];
+      pos+=freq;
+    }
+    if (pos>=end) {
+      if (!loop) {
+        for (; i<len; i++) out[i]=0;
+        return false;
+      }
+      pos=((unsigned int)src.loopStart)<<shift;
+    }
+  }
+  return true;
+}
+
+/**
+ * render a voice which holds a value and fetches the next one every time its
+ * counter runs out (e.g. Amiga).
+ * @param sub the counter. it goes down by step every output sample and up by period on every fetch.
+ * @param hold the last fetched value.
+ * @return false if the sample ended. the rest of out holds the last value.
+ */
+template<typename T, bool loop> bool divPCMRenderCounter(const DivPCMSource<T>& src, unsigned int& pos, int& sub, T& hold, int step, int period, int* out, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    sub-=step;
+    if (sub<0) {
+      hold=src.data[pos++];
+      sub+=period;
+      if (pos>=src.end) {
+        if (!loop) {
+          for (; i<len; i++) out[i]=hold;
+          return false;
+        }
+        pos=src.loopStart;
+      }
+    }
+    out[i]=hold;
+  }
+  return true;
+}
+
+/**
+ * mix a rendered voice into the output.
+ * every value is multiplied by the volume and then shifted right.
+ * @param tapL if not NULL, the voice's output is written here as well.
+ */
+template<bool stereo> void divPCMMix(const int* in, size_t len, int volL, int volR, int shift, int* outL, int* outR, short* tapL, short* tapR) {
+  if (tapL!=NULL) {
+    for (size_t i=0; i<len; i++) {
+      int l=(in[i]*volL)>>shift;
+      outL[i]+=l;
+      tapL[i]=l;
+      if (stereo) {
+        int r=(in[i]*volR)>>shift;
+        outR[i]+=r;
+        tapR[i]=r;
+      }
+    }
+  } else {
+    for (size_t i=0; i<len; i++) {
+      outL[i]+=(in[i]*volL)>>shift;
+      if (stereo) outR[i]+=(in[i]*volR)>>shift;
+    }
+  }
+}
+
+#endif
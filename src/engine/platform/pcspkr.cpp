@@ -309,6 +309,27 @@ void* DivPlatformPCSpeaker::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformPCSpeaker::getState() {
+  DivPlatformPCSpeaker* st=new DivPlatformPCSpeaker(*this);
+  st->beepFD=-1;
+  return st;
+}
+
+void DivPlatformPCSpeaker::setState(void* state) {
+  // the real speaker keeps playing what it was told last.
+  int keepFD=beepFD;
+  bool keepOn=lastOn;
+  unsigned short keepFreq=lastFreq;
+  assignState(this,(DivPlatformPCSpeaker*)state);
+  beepFD=keepFD;
+  lastOn=keepOn;
+  lastFreq=keepFreq;
+}
+
+void DivPlatformPCSpeaker::freeState(void* state) {
+  delete (DivPlatformPCSpeaker*)state;
+}
+
 unsigned char* DivPlatformPCSpeaker::getRegisterPool() {
   if (on) {
     regPool[0]=freq;
@@ -265,12 +265,30 @@ const char* DivPlatformQSound::getEffectName(unsigned char effect) {
   return NULL;
 }
 void DivPlatformQSound::acquire(short* bufL, short* bufR, size_t start, size_t len) {
-  chip.rom_data = parent->qsoundMem;
-  chip.rom_mask = 0xffffff;
+  if (parent->qsoundMem.data==NULL) {
+    chip.rom_data = (unsigned char*)&chip.rom_mask;
+    chip.rom_mask = 0;
+  } else {
+    chip.rom_data = parent->qsoundMem.data;
+    chip.rom_mask = parent->qsoundMem.len-1;
+  }
   for (size_t h=start; h<start+len; h++) {
     qsound_update(&chip);
     bufL[h]=chip.out[0];
     bufR[h]=chip.out[1];
+
+    // taps only include the dry and wet mix of each voice (no echo and FIR filter).
+    if (tapL!=NULL) for (int i=0; i<19; i++) {
+      unsigned short panIndex=MIN(97,(unsigned short)(chip.voice_pan[i]-0x110));
+      int out[2];
+      for (int j=0; j<2; j++) {
+        int dry=-(chip.voice_output[i]*chip.pan_tables[j][0][panIndex]);
+        int wet=-(chip.voice_output[i]*chip.pan_tables[j][1][panIndex]);
+        out[j]=(((dry>>14)*chip.dry[j].volume)+((wet>>14)*chip.wet[j].volume)+0x2000)>>14;
+      }
+      tapL[i][h]=MAX(-32767,MIN(32767,out[0]));
+      tapR[i][h]=MAX(-32767,MIN(32767,out[1]));
+    }
   }
 }
 
@@ -500,6 +518,13 @@ int DivPlatformQSound::dispatch(DivCommand c) {
   return 1;
 }
 
+bool DivPlatformQSound::setChanTaps(short** l, short** r, int chans) {
+  if (l!=NULL && chans<19) return false;
+  tapL=l;
+  tapR=r;
+  return true;
+}
+
 void DivPlatformQSound::muteChannel(int ch, bool mute) {
   if (mute) {
     chip.mute_mask|=(1<<ch);
@@ -520,6 +545,22 @@ void* DivPlatformQSound::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformQSound::getState() {
+  return new DivPlatformQSound(*this);
+}
+
+void DivPlatformQSound::setState(void* state) {
+  // the register map points into the chip itself.
+  uint16_t* regMap[256];
+  memcpy(regMap,chip.register_map,sizeof(regMap));
+  assignState(this,(DivPlatformQSound*)state);
+  memcpy(chip.register_map,regMap,sizeof(regMap));
+}
+
+void DivPlatformQSound::freeState(void* state) {
+  delete (DivPlatformQSound*)state;
+}
+
 void DivPlatformQSound::reset() {
   for (int i=0; i<16; i++) {
     chan[i]=DivPlatformQSound::Channel();
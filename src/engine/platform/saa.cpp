@@ -369,6 +369,32 @@ void* DivPlatformSAA1099::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformSAA1099::getState() {
+  // SAASound does not expose its state.
+  if (core==DIV_SAA_CORE_SAASOUND) return NULL;
+  DivPlatformSAA1099* st=new DivPlatformSAA1099(*this);
+  st->saa_saaSound=NULL;
+  for (int i=0; i<2; i++) st->saaBuf[i]=NULL;
+  st->saaBufLen=0;
+  return st;
+}
+
+void DivPlatformSAA1099::setState(void* state) {
+  DivPlatformSAA1099* st=(DivPlatformSAA1099*)state;
+  CSAASound* keepSAASound=saa_saaSound;
+  short* keepBuf[2];
+  for (int i=0; i<2; i++) keepBuf[i]=saaBuf[i];
+  size_t keepBufLen=saaBufLen;
+  assignState(this,st);
+  saa_saaSound=keepSAASound;
+  for (int i=0; i<2; i++) saaBuf[i]=keepBuf[i];
+  saaBufLen=keepBufLen;
+}
+
+void DivPlatformSAA1099::freeState(void* state) {
+  delete (DivPlatformSAA1099*)state;
+}
+
 unsigned char* DivPlatformSAA1099::getRegisterPool() {
   return regPool;
 }
@@ -378,7 +404,7 @@ int DivPlatformSAA1099::getRegisterPoolSize() {
 }
 
 void DivPlatformSAA1099::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
   memset(regPool,0,32);
   switch (core) {
     case DIV_SAA_CORE_MAME:
@@ -19,6 +19,7 @@
 
 #include "segapcm.h"
 #include "../engine.h"
+#include "pcmVoice.h"
 #include <string.h>
 #include <math.h>
 
@@ -35,44 +36,54 @@ const char* DivPlatformSegaPCM::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformSegaPCM::acquire(short* bufL, short* bufR, size_t start, size_t len) {
-  static int os[2];
-
-  for (size_t h=start; h<start+len; h++) {
-    os[0]=0; os[1]=0;
-    // do a PCM cycle
-    pcmL=0; pcmR=0;
+  int mixL[DIV_PCM_BLOCK];
+  int mixR[DIV_PCM_BLOCK];
+  int voice[DIV_PCM_BLOCK];
+  DivPCMSource<signed char> src;
+  while (len>0) {
+    size_t blockLen=MIN(len,DIV_PCM_BLOCK);
+    memset(mixL,0,blockLen*sizeof(int));
+    memset(mixR,0,blockLen*sizeof(int));
     for (int i=0; i<16; i++) {
-      if (chan[i].pcm.sample>=0 && chan[i].pcm.sample<parent->song.sampleLen) {
-        DivSample* s=parent->getSample(chan[i].pcm.sample);
-        if (s->samples<=0) {
-          chan[i].pcm.sample=-1;
-          continue;
+      bool valid=(chan[i].pcm.sample>=0 && chan[i].pcm.sample<parent->song.sampleLen);
+      if (valid && src.bind(parent->getSample(chan[i].pcm.sample))) {
+        bool playing;
+        if (src.loopStart>=0) {
+          playing=divPCMRenderPhase<signed char,true,8>(src,chan[i].pcm.pos,chan[i].pcm.freq,voice,blockLen);
+        } else {
+          playing=divPCMRenderPhase<signed char,false,8>(src,chan[i].pcm.pos,chan[i].pcm.freq,voice,blockLen);
         }
         if (!isMuted[i]) {
-          pcmL+=(s->data8[chan[i].pcm.pos>>8]*chan[i].chVolL);
-          pcmR+=(s->data8[chan[i].pcm.pos>>8]*chan[i].chVolR);
+          divPCMMix<true>(voice,blockLen,chan[i].chVolL,chan[i].chVolR,0,mixL,mixR,
+            (tapL==NULL)?NULL:(tapL[i]+start),
+            (tapR==NULL)?NULL:(tapR[i]+start)
+          );
+        } else if (tapL!=NULL) {
+          memset(tapL[i]+start,0,blockLen*sizeof(short));
+          memset(tapR[i]+start,0,blockLen*sizeof(short));
         }
-        chan[i].pcm.pos+=chan[i].pcm.freq;
-        if (chan[i].pcm.pos>=(s->samples<<8)) {
-          if (s->loopStart>=0 && s->loopStart<=(int)s->samples) {
-            chan[i].pcm.pos=s->loopStart<<8;
-          } else {
-            chan[i].pcm.sample=-1;
-          }
+        if (!playing) chan[i].pcm.sample=-1;
+      } else {
+        if (valid) chan[i].pcm.sample=-1;
+        if (tapL!=NULL) {
+          memset(tapL[i]+start,0,blockLen*sizeof(short));
+          memset(tapR[i]+start,0,blockLen*sizeof(short));
         }
       }
     }
 
-    os[0]=pcmL;
-    if (os[0]<-32768) os[0]=-32768;
-    if (os[0]>32767) os[0]=32767;
-
-    os[1]=pcmR;
-    if (os[1]<-32768) os[1]=-32768;
-    if (os[1]>32767) os[1]=32767;
-  
-    bufL[h]=os[0];
-    bufR[h]=os[1];
+    for (size_t h=0; h<blockLen; h++) {
+      pcmL=mixL[h];
+      if (pcmL<-32768) pcmL=-32768;
+      if (pcmL>32767) pcmL=32767;
+      pcmR=mixR[h];
+      if (pcmR<-32768) pcmR=-32768;
+      if (pcmR>32767) pcmR=32767;
+      bufL[start+h]=pcmL;
+      bufR[start+h]=pcmR;
+    }
+    start+=blockLen;
+    len-=blockLen;
   }
 }
 
@@ -113,7 +124,7 @@ void DivPlatformSegaPCM::tick() {
           DivSample* s=parent->getSample(chan[i].pcm.sample);
           off=(double)s->centerRate/8363.0;
         }
-        chan[i].pcm.freq=MIN(255,((off*parent->song.tuning*pow(2.0,double(chan[i].freq+256)/(64.0*12.0)))*255)/31250);
+        chan[i].pcm.freq=MIN(255,((off*parent->song.tuning*parent->pitchMult((chan[i].freq+256)*2))*255)/31250);
         if (dumpWrites && i>=8) {
           addWrite(0x10007+((i-8)<<3),chan[i].pcm.freq);
         }
@@ -123,6 +134,14 @@ void DivPlatformSegaPCM::tick() {
   }
 }
 
+bool DivPlatformSegaPCM::setChanTaps(short** l, short** r, int chans) {
+  // all 16 voices are rendered, even in the 5-channel DefleMask variant
+  if (l!=NULL && chans<16) return false;
+  tapL=l;
+  tapR=r;
+  return true;
+}
+
 void DivPlatformSegaPCM::muteChannel(int ch, bool mute) {
   isMuted[ch]=mute;
 }
@@ -327,6 +346,18 @@ void* DivPlatformSegaPCM::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformSegaPCM::getState() {
+  return new DivPlatformSegaPCM(*this);
+}
+
+void DivPlatformSegaPCM::setState(void* state) {
+  assignState(this,(DivPlatformSegaPCM*)state);
+}
+
+void DivPlatformSegaPCM::freeState(void* state) {
+  delete (DivPlatformSegaPCM*)state;
+}
+
 unsigned char* DivPlatformSegaPCM::getRegisterPool() {
   return regPool;
 }
@@ -344,7 +375,7 @@ void DivPlatformSegaPCM::poke(std::vector<DivRegWrite>& wlist) {
 }
 
 void DivPlatformSegaPCM::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
   memset(regPool,0,256);
   for (int i=0; i<16; i++) {
     chan[i]=DivPlatformSegaPCM::Channel();
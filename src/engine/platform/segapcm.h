@@ -21,7 +21,7 @@
 #define _SEGAPCM_H
 #include "../dispatch.h"
 #include "../instrument.h"
-#include <queue>
+#include "writeQueue.h"
 #include "../macroInt.h"
 
 class DivPlatformSegaPCM: public DivDispatch {
@@ -50,9 +50,10 @@ class DivPlatformSegaPCM: public DivDispatch {
       unsigned short addr;
       unsigned char val;
       bool addrOrVal;
+      QueuedWrite(): addr(0), val(0), addrOrVal(false) {}
       QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
     };
-    std::queue<QueuedWrite> writes;
+    DivWriteQueue<QueuedWrite> writes;
     int delay, baseFreqOff;
     int pcmL, pcmR, pcmCycles;
     unsigned char sampleBank;
@@ -74,6 +75,10 @@ class DivPlatformSegaPCM: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
+    bool setChanTaps(short** l, short** r, int chans);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
@@ -44,7 +44,15 @@ const char* DivPlatformSMS::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformSMS::acquire(short* bufL, short* bufR, size_t start, size_t len) {
-  sn->sound_stream_update(bufL+start,len);
+  if (tapL!=NULL) {
+    short* tapOut[4];
+    for (int i=0; i<4; i++) {
+      tapOut[i]=tapL[i]+start;
+    }
+    sn->sound_stream_update(bufL+start,len,tapOut);
+  } else {
+    sn->sound_stream_update(bufL+start,len);
+  }
 }
 
 int DivPlatformSMS::acquireOne() {
@@ -241,6 +249,13 @@ int DivPlatformSMS::dispatch(DivCommand c) {
   return 1;
 }
 
+bool DivPlatformSMS::setChanTaps(short** l, short** r, int chans) {
+  if (l!=NULL && chans<4) return false;
+  tapL=l;
+  tapR=r;
+  return true;
+}
+
 void DivPlatformSMS::muteChannel(int ch, bool mute) {
   isMuted[ch]=mute;
   if (chan[ch].active) rWrite(0x90|ch<<5|(isMuted[ch]?15:(15-(chan[ch].outVol&15))));
@@ -260,6 +275,27 @@ void* DivPlatformSMS::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformSMS::getState() {
+  DivPlatformSMS* st=new DivPlatformSMS(*this);
+  st->sn=new sn76496_base_device(*sn);
+  return st;
+}
+
+void DivPlatformSMS::setState(void* state) {
+  DivPlatformSMS* st=(DivPlatformSMS*)state;
+  sn76496_base_device* core=sn;
+  assignState(this,st);
+  sn=core;
+  // the constant members are the same as both come from the same setFlags() call.
+  memcpy((void*)sn,st->sn,sizeof(sn76496_base_device));
+}
+
+void DivPlatformSMS::freeState(void* state) {
+  DivPlatformSMS* st=(DivPlatformSMS*)state;
+  delete st->sn;
+  delete st;
+}
+
 void DivPlatformSMS::reset() {
   for (int i=0; i<4; i++) {
     chan[i]=DivPlatformSMS::Channel();
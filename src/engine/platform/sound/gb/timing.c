@@ -93,7 +93,7 @@ main:
     }
 }
 
-void GB_advance_cycles(GB_gameboy_t *gb, uint8_t cycles)
+static inline void advance_cycles(GB_gameboy_t *gb, uint8_t cycles)
 {
     gb->apu.pcm_mask[0] = gb->apu.pcm_mask[1] = 0xFF; // Sort of hacky, but too many cross-component interactions to do it right
 
@@ -108,6 +108,21 @@ void GB_advance_cycles(GB_gameboy_t *gb, uint8_t cycles)
     GB_apu_run(gb);
 }
 
+void GB_advance_cycles(GB_gameboy_t *gb, uint8_t cycles)
+{
+    advance_cycles(gb, cycles);
+}
+
+/* Same as calling GB_advance_cycles count times and reading final_sample after each call */
+void GB_advance_cycles_batch(GB_gameboy_t *gb, uint8_t cycles, int16_t *left, int16_t *right, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        advance_cycles(gb, cycles);
+        left[i] = gb->apu_output.final_sample.left;
+        right[i] = gb->apu_output.final_sample.right;
+    }
+}
+
 /* 
    This glitch is based on the expected results of mooneye-gb rapid_toggle test.
    This glitch happens because how TIMA is increased, see GB_set_internal_div_counter.
@@ -3,6 +3,7 @@
 #include "gb_struct_def.h"
 
 void GB_advance_cycles(GB_gameboy_t *gb, uint8_t cycles);
+void GB_advance_cycles_batch(GB_gameboy_t *gb, uint8_t cycles, int16_t *left, int16_t *right, size_t count);
 void GB_emulate_timer_glitch(GB_gameboy_t *gb, uint8_t old_tac, uint8_t new_tac);
 bool GB_timing_sync_turbo(GB_gameboy_t *gb); /* Returns true if should skip frame */
 void GB_timing_sync(GB_gameboy_t *gb);
@@ -508,6 +508,22 @@ Mikey::Mikey( uint32_t sampleRate ) : mMikey{ std::make_unique<MikeyPimpl>() },
   enqueueSampling();
 }
 
+Mikey::Mikey( Mikey const& other ) : mMikey{ std::make_unique<MikeyPimpl>( *other.mMikey ) }, mQueue{ std::make_unique<ActionQueue>( *other.mQueue ) }, mTick{ other.mTick }, mNextTick{ other.mNextTick }, mSampleRate{ other.mSampleRate }, mSamplesRemainder{ other.mSamplesRemainder }, mTicksPerSample{ other.mTicksPerSample }
+{
+}
+
+Mikey& Mikey::operator=( Mikey const& other )
+{
+  *mMikey = *other.mMikey;
+  *mQueue = *other.mQueue;
+  mTick = other.mTick;
+  mNextTick = other.mNextTick;
+  mSampleRate = other.mSampleRate;
+  mSamplesRemainder = other.mSamplesRemainder;
+  mTicksPerSample = other.mTicksPerSample;
+  return *this;
+}
+
 Mikey::~Mikey()
 {
 }
@@ -15,6 +15,8 @@ public:
 
 
   Mikey( uint32_t sampleRate );
+  Mikey( Mikey const& other );
+  Mikey& operator=( Mikey const& other );
   ~Mikey();
 
   void write( uint8_t address, uint8_t value );
@@ -190,6 +190,50 @@ void apu_tick(struct NESAPU* a, BYTE *hwtick) {
 
 	a->r4011.cycles++;
 }
+/*
+ * returns how many of the following cycles would only count down
+ * the timers, without changing the output or any other state.
+ * these may be run all at once with apu_skip().
+ */
+#define apu_idle_limit(timer)\
+	if ((timer) <= 1) {\
+		return 0;\
+	}\
+	if ((WORD) ((timer) - 1) < idle) {\
+		idle = (timer) - 1;\
+	}
+WORD apu_idle_cycles(struct NESAPU* a) {
+	WORD idle = 0xFFFF;
+
+	if (a->r4017.jitter.delay || a->r4017.reset_frame_delay) {
+		return 0;
+	}
+	if (a->DMC.empty && a->DMC.remain) {
+		return 0;
+	}
+	apu_idle_limit(a->apu.cycles)
+	apu_idle_limit(a->S1.frequency)
+	apu_idle_limit(a->S2.frequency)
+	apu_idle_limit(a->TR.frequency)
+	apu_idle_limit(a->NS.frequency)
+	apu_idle_limit(a->DMC.frequency)
+	return idle;
+}
+#undef apu_idle_limit
+/*
+ * equivalent to calling apu_tick() the given number of times,
+ * as long as it is not more than apu_idle_cycles().
+ */
+void apu_skip(struct NESAPU* a, WORD cycles) {
+	a->apu.cycles -= cycles;
+	a->apu.length_clocked = FALSE;
+	a->S1.frequency -= cycles;
+	a->S2.frequency -= cycles;
+	a->TR.frequency -= cycles;
+	a->NS.frequency -= cycles;
+	a->DMC.frequency -= cycles;
+	a->r4011.cycles += cycles;
+}
 void apu_turn_on(struct NESAPU* a, BYTE apu_type) {
 	memset(&a->apu, 0x00, sizeof(a->apu));
 	memset(&a->r4015, 0x00, sizeof(a->r4015));
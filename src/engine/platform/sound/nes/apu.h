@@ -630,6 +630,8 @@ static const WORD dmc_rate[3][16] = {
 
 EXTERNC void apu_tick(struct NESAPU* a, BYTE *hwtick);
 EXTERNC void apu_turn_on(struct NESAPU* a, BYTE apu_type);
+EXTERNC WORD apu_idle_cycles(struct NESAPU* a);
+EXTERNC void apu_skip(struct NESAPU* a, WORD cycles);
 
 #undef EXTERNC
 
@@ -72,6 +72,11 @@ inline void PCE_PSG::UpdateOutputSub(const int32_t timestamp, psg_channel *ch, c
 {
   HRBufs[0][timestamp]+=samp0;
   HRBufs[1][timestamp]+=samp1;
+  const int chc=ch-channel;
+  if (ChanHRBufs[chc][0]!=NULL) {
+    ChanHRBufs[chc][0][timestamp]+=samp0;
+    ChanHRBufs[chc][1][timestamp]+=samp1;
+  }
   /*
  int32_t delta[2];
 
@@ -428,6 +433,8 @@ PCE_PSG::PCE_PSG(int32_t* hr_l, int32_t* hr_r, int want_revision)
   lastts = 0;
   for(int ch = 0; ch < 6; ch++)
   {
+   ChanHRBufs[ch][0] = NULL;
+   ChanHRBufs[ch][1] = NULL;
    channel[ch].blip_prev_samp[0] = 0;
    channel[ch].blip_prev_samp[1] = 0;
    channel[ch].lastts = 0;
@@ -437,6 +444,12 @@ PCE_PSG::PCE_PSG(int32_t* hr_l, int32_t* hr_r, int want_revision)
   Power(0);
 }
 
+void PCE_PSG::SetChanHRBufs(int ch, int32_t* hr_l, int32_t* hr_r)
+{
+  ChanHRBufs[ch][0] = hr_l;
+  ChanHRBufs[ch][1] = hr_r;
+}
+
 PCE_PSG::~PCE_PSG()
 {
 
@@ -141,6 +141,9 @@ class PCE_PSG
   void Update(int32_t timestamp);
   void ResetTS(int32_t ts_base = 0);
 
+  // per-channel copy of the output buffers. set to NULL to disable.
+  void SetChanHRBufs(int ch, int32_t* hr_l, int32_t* hr_r);
+
   // TODO: timestamp
   uint32_t GetRegister(const unsigned int id, char *special, const uint32_t special_len);
   void SetRegister(const unsigned int id, const uint32_t value);
@@ -184,6 +187,7 @@ class PCE_PSG
   int revision;
 
   int32_t* HRBufs[2];
+  int32_t* ChanHRBufs[6][2];
 
   int32_t dbtable_volonly[32];
 
@@ -301,6 +301,8 @@ static inline int16_t get_sample(struct qsound_chip *chip, uint16_t bank,uint16_
 
 	bank &= 0x7FFF;
 	rom_addr = (bank << 16) | (address << 0);
+	if (rom_addr > chip->rom_mask)
+		return 0;	// past the end of the ROM (rom_mask is the last valid address)
 
 	sample_data = chip->rom_data[rom_addr];
 
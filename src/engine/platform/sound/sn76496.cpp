@@ -285,7 +285,7 @@ inline bool sn76496_base_device::in_noise_mode()
 	return ((m_register[6] & 4)!=0);
 }
 
-void sn76496_base_device::sound_stream_update(short* outputs, int outLen)
+void sn76496_base_device::sound_stream_update(short* outputs, int outLen, short** chanOutputs)
 {
 	int i;
 
@@ -344,5 +344,14 @@ void sn76496_base_device::sound_stream_update(short* outputs, int outLen)
 		if (m_negate) { out = -out; out2 = -out2; }
 
 		outputs[sampindex]=out;
+
+		if (chanOutputs!=NULL)
+		{
+			for (i = 0; i < 4; i++)
+			{
+				int16_t chanOut = (m_output[i]!=0)? m_volume[i]:0;
+				chanOutputs[i][sampindex] = m_negate? -chanOut : chanOut;
+			}
+		}
 	}
 }
@@ -15,7 +15,7 @@ public:
 	void stereo_w(u8 data);
 	void write(u8 data);
   void device_start();
-	void sound_stream_update(short* outputs, int outLen);
+	void sound_stream_update(short* outputs, int outLen, short** chanOutputs=NULL);
 	//DECLARE_READ_LINE_MEMBER( ready_r ) { return m_ready_state ? 1 : 0; }
 
 	sn76496_base_device(
@@ -174,12 +174,10 @@ class TIASound
     */
     static const unsigned char Div31[POLY5_SIZE];
 
-  private:
-    // Following constructors and assignment operators not supported
-    TIASound(const TIASound&) = delete;
-    TIASound(TIASound&&) = delete;
-    TIASound& operator=(const TIASound&) = delete;
-    TIASound& operator=(TIASound&&) = delete;
+  public:
+    // copying is allowed for state saves
+    TIASound(const TIASound&) = default;
+    TIASound& operator=(const TIASound&) = default;
 };
 
 #endif
@@ -19,6 +19,7 @@
 
 #include "swan.h"
 #include "../engine.h"
+#include "pcmVoice.h"
 #include <math.h>
 
 #define rWrite(a,v) if (!skipRegisterWrites) {writes.emplace(a,v); if (dumpWrites) {addWrite(a,v);}}
@@ -72,23 +73,22 @@ const char* DivPlatformSwan::getEffectName(unsigned char effect) {
 }
 
 void DivPlatformSwan::acquire(short* bufL, short* bufR, size_t start, size_t len) {
+  DivPCMSource<signed char> dac;
+  bool dacActive=false;
+  if (pcm && dacSample!=-1) {
+    dacActive=dac.bind(parent->getSample(dacSample));
+    if (!dacActive) dacSample=-1;
+  }
+
   for (size_t h=start; h<start+len; h++) {
     // PCM part
-    if (pcm && dacSample!=-1) {
+    if (dacActive) {
       dacPeriod+=dacRate;
-      while (dacPeriod>rate) {
-        DivSample* s=parent->getSample(dacSample);
-        if (s->samples<=0) {
+      while (dacActive && dacPeriod>rate) {
+        rWrite(0x09,(unsigned char)dac.data[dacPos]+0x80);
+        if (!dac.advance(dacPos)) {
           dacSample=-1;
-          continue;
-        }
-        rWrite(0x09,(unsigned char)s->data8[dacPos++]+0x80);
-        if (dacPos>=s->samples) {
-          if (s->loopStart>=0 && s->loopStart<=(int)s->samples) {
-            dacPos=s->loopStart;
-          } else {
-            dacSample=-1;
-          }
+          dacActive=false;
         }
         dacPeriod-=rate;
       }
@@ -436,6 +436,26 @@ void* DivPlatformSwan::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformSwan::getState() {
+  DivPlatformSwan* st=new DivPlatformSwan(*this);
+  st->ws=new WSwan(*ws);
+  return st;
+}
+
+void DivPlatformSwan::setState(void* state) {
+  DivPlatformSwan* st=(DivPlatformSwan*)state;
+  WSwan* core=ws;
+  assignState(this,st);
+  ws=core;
+  *ws=*st->ws;
+}
+
+void DivPlatformSwan::freeState(void* state) {
+  DivPlatformSwan* st=(DivPlatformSwan*)state;
+  delete st->ws;
+  delete st;
+}
+
 unsigned char* DivPlatformSwan::getRegisterPool() {
   // get Random from emulator
   regPool[0x12]=ws->SoundRead(0x92);
@@ -448,7 +468,7 @@ int DivPlatformSwan::getRegisterPoolSize() {
 }
 
 void DivPlatformSwan::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
   memset(regPool,0,128);
   for (int i=0; i<4; i++) {
     chan[i]=Channel();
@@ -23,7 +23,7 @@
 #include "../dispatch.h"
 #include "../macroInt.h"
 #include "sound/swan.h"
-#include <queue>
+#include "writeQueue.h"
 
 class DivPlatformSwan: public DivDispatch {
   struct Channel {
@@ -61,9 +61,10 @@ class DivPlatformSwan: public DivDispatch {
   struct QueuedWrite {
       unsigned char addr;
       unsigned char val;
+      QueuedWrite(): addr(0), val(0) {}
       QueuedWrite(unsigned char a, unsigned char v): addr(a), val(v) {}
   };
-  std::queue<QueuedWrite> writes;
+  DivWriteQueue<QueuedWrite> writes;
   WSwan* ws;
   void updateWave(int ch);
   friend void putDispatchChan(void*,int,int);
@@ -71,6 +72,9 @@ class DivPlatformSwan: public DivDispatch {
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
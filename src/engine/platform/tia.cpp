@@ -281,6 +281,18 @@ void* DivPlatformTIA::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformTIA::getState() {
+  return new DivPlatformTIA(*this);
+}
+
+void DivPlatformTIA::setState(void* state) {
+  assignState(this,(DivPlatformTIA*)state);
+}
+
+void DivPlatformTIA::freeState(void* state) {
+  delete (DivPlatformTIA*)state;
+}
+
 unsigned char* DivPlatformTIA::getRegisterPool() {
   return regPool;
 }
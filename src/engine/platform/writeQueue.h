@@ -0,0 +1,160 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _WRITEQUEUE_H
+#define _WRITEQUEUE_H
+#include <stddef.h>
+#include <deque>
+#include "../../ta-log.h"
+
+// default capacity of a DivWriteQueue. enough for a full chip reset.
+#define DIV_WRITE_QUEUE_SIZE 4096
+
+/**
+ * a fixed-capacity queue of register writes.
+ * every write carries the output sample it is due on, so acquire() can run the
+ * chip up to the next write instead of checking the queue every sample.
+ * the queue does not allocate after construction unless it overflows. writes past
+ * the capacity go to a spill list, so none are lost.
+ * @tparam T the write type. must be default-constructible.
+ * @tparam N the capacity. must be a power of 2.
+ */
+template<typename T, size_t N=DIV_WRITE_QUEUE_SIZE> class DivWriteQueue {
+  T data[N];
+  unsigned int time[N];
+  size_t readPos, writePos, count;
+  unsigned int now, last, spacing;
+  // writes which did not fit, in order. they move into the ring as it drains.
+  std::deque<std::pair<T,unsigned int>> spill;
+  bool warned;
+
+  void put(const T& w, unsigned int t) {
+    data[writePos]=w;
+    time[writePos]=t;
+    writePos=(writePos+1)&(N-1);
+    count++;
+  }
+
+  public:
+    /**
+     * queue a write.
+     * it is due spacing samples after the previous one, or right away if that has passed.
+     * @return true. if the queue is full, the write is kept in the spill list.
+     */
+    bool push(const T& w) {
+      unsigned int t=last+spacing;
+      if ((int)(t-now)<0) t=now;
+      last=t;
+      if (count>=N || !spill.empty()) {
+        if (!warned) {
+          logW("register write queue overflow! (%d writes)\n",(int)N);
+          warned=true;
+        }
+        spill.push_back(std::pair<T,unsigned int>(w,t));
+        return true;
+      }
+      put(w,t);
+      return true;
+    }
+
+    /**
+     * construct and queue a write.
+     */
+    template<typename... A> bool emplace(A... args) {
+      return push(T(args...));
+    }
+
+    T& front() {
+      return data[readPos];
+    }
+
+    void pop() {
+      if (count==0) return;
+      readPos=(readPos+1)&(N-1);
+      count--;
+      if (!spill.empty()) {
+        put(spill.front().first,spill.front().second);
+        spill.pop_front();
+      }
+    }
+
+    bool empty() {
+      return count==0;
+    }
+
+    size_t size() {
+      return count+spill.size();
+    }
+
+    /**
+     * drop every write.
+     */
+    void clear() {
+      readPos=0;
+      writePos=0;
+      count=0;
+      spill.clear();
+      last=now-spacing;
+    }
+
+    /**
+     * check whether the front write is due.
+     */
+    bool due() {
+      return count>0 && (int)(time[readPos]-now)<=0;
+    }
+
+    /**
+     * get the number of samples until the front write is due.
+     * only call if the queue is not empty.
+     */
+    unsigned int untilNext() {
+      int left=(int)(time[readPos]-now);
+      return (left<0)?0:left;
+    }
+
+    /**
+     * move the clock forward. call after running the chip.
+     * @param samples the number of samples that were generated.
+     */
+    void advance(unsigned int samples) {
+      now+=samples;
+    }
+
+    /**
+     * set the number of samples between two writes.
+     * 0 makes every write due right away.
+     */
+    void setSpacing(unsigned int s) {
+      spacing=s;
+      last=now-spacing;
+    }
+
+    DivWriteQueue():
+      readPos(0),
+      writePos(0),
+      count(0),
+      now(0),
+      last(0),
+      spacing(0),
+      warned(false) {}
+};
+
+#endif
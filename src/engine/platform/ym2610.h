@@ -21,9 +21,12 @@
 #define _YM2610_H
 #include "../dispatch.h"
 #include "../macroInt.h"
-#include <queue>
+#include "writeQueue.h"
 #include "sound/ymfm/ymfm_opn.h"
 
+// maximum number of samples generated by ymfm in a single call
+#define YM2610_YMFM_BATCH 256
+
 class DivYM2610Interface: public ymfm::ymfm_interface {
   public:
     DivEngine* parent;
@@ -35,9 +38,7 @@ class DivYM2610Interface: public ymfm::ymfm_interface {
 
 class DivPlatformYM2610: public DivDispatch {
   protected:
-    const unsigned short chanOffs[4]={
-      0x01, 0x02, 0x101, 0x102
-    };
+    static const unsigned short chanOffs[4];
 
     struct Channel {
       DivInstrumentFM state;
@@ -78,11 +79,12 @@ class DivPlatformYM2610: public DivDispatch {
       unsigned short addr;
       unsigned char val;
       bool addrOrVal;
+      QueuedWrite(): addr(0), val(0), addrOrVal(false) {}
       QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
     };
-    std::queue<QueuedWrite> writes;
+    DivWriteQueue<QueuedWrite> writes;
     ymfm::ym2610* fm;
-    ymfm::ym2610::output_data fmout;
+    ymfm::ym2610::output_data fmout[YM2610_YMFM_BATCH];
     DivYM2610Interface iface;
     unsigned char regPool[512];
     unsigned char lastBusy;
@@ -95,7 +97,6 @@ class DivPlatformYM2610: public DivDispatch {
     int ayNoiseFreq;
     unsigned char sampleBank;
 
-    int delay;
 
     bool extMode;
   
@@ -109,12 +110,18 @@ class DivPlatformYM2610: public DivDispatch {
     int octave(int freq);
     int toFreq(int freq);
     double NOTE_ADPCMB(int note);
+
+    void cloneCore(DivPlatformYM2610* st);
+    void restoreCore(DivPlatformYM2610* st, ymfm::ym2610* core, const DivYM2610Interface& coreIface);
     friend void putDispatchChan(void*,int,int);
   
   public:
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
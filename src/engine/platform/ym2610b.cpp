@@ -26,6 +26,10 @@
 
 #include "fmshared_OPN.h"
 
+const unsigned short DivPlatformYM2610B::chanOffs[6]={
+  0x00, 0x01, 0x02, 0x100, 0x101, 0x102
+};
+
 static unsigned char konOffs[6]={
   0, 1, 2, 4, 5, 6
 };
@@ -385,33 +389,38 @@ double DivPlatformYM2610B::NOTE_ADPCMB(int note) {
 }
 
 void DivPlatformYM2610B::acquire(short* bufL, short* bufR, size_t start, size_t len) {
-  static int os[2];
+  int os[2];
+  size_t h=start;
+  size_t end=start+len;
 
-  for (size_t h=start; h<start+len; h++) {
-    os[0]=0; os[1]=0;
-    if (!writes.empty()) {
-      if (--delay<1) {
-        QueuedWrite& w=writes.front();
-        fm->write(0x0+((w.addr>>8)<<1),w.addr);
-        fm->write(0x1+((w.addr>>8)<<1),w.val);
-        regPool[w.addr&0x1ff]=w.val;
-        writes.pop();
-        delay=4;
-      }
+  // generate in runs which end whenever a register write is due
+  while (h<end) {
+    size_t runLen=MIN(end-h,YM2610_YMFM_BATCH);
+    if (writes.due()) {
+      QueuedWrite& w=writes.front();
+      fm->write(0x0+((w.addr>>8)<<1),w.addr);
+      fm->write(0x1+((w.addr>>8)<<1),w.val);
+      regPool[w.addr&0x1ff]=w.val;
+      writes.pop();
     }
+    // run up to the next write
+    if (!writes.empty()) runLen=MIN(runLen,(size_t)MAX(1,writes.untilNext()));
     
-    fm->generate(&fmout);
+    fm->generate(fmout,runLen);
+    writes.advance(runLen);
 
-    os[0]=fmout.data[0]+(fmout.data[2]>>1);
-    if (os[0]<-32768) os[0]=-32768;
-    if (os[0]>32767) os[0]=32767;
+    for (size_t i=0; i<runLen; i++, h++) {
+      os[0]=fmout[i].data[0]+(fmout[i].data[2]>>1);
+      if (os[0]<-32768) os[0]=-32768;
+      if (os[0]>32767) os[0]=32767;
 
-    os[1]=fmout.data[1]+(fmout.data[2]>>1);
-    if (os[1]<-32768) os[1]=-32768;
-    if (os[1]>32767) os[1]=32767;
+      os[1]=fmout[i].data[1]+(fmout[i].data[2]>>1);
+      if (os[1]<-32768) os[1]=-32768;
+      if (os[1]>32767) os[1]=32767;
   
-    bufL[h]=os[0];
-    bufR[h]=os[1];
+      bufL[h]=os[0];
+      bufR[h]=os[1];
+    }
   }
 }
 
@@ -1229,6 +1238,45 @@ void* DivPlatformYM2610B::getChanState(int ch) {
   return &chan[ch];
 }
 
+void DivPlatformYM2610B::cloneCore(DivPlatformYM2610B* st) {
+  std::vector<unsigned char> coreState;
+  ymfm::ymfm_saved_state saver(coreState,true);
+  fm->save_restore(saver);
+  st->fm=new ymfm::ym2610b(st->iface);
+  ymfm::ymfm_saved_state loader(coreState,false);
+  st->fm->save_restore(loader);
+}
+
+void DivPlatformYM2610B::restoreCore(DivPlatformYM2610B* st, ymfm::ym2610b* core, const DivYM2610Interface& coreIface) {
+  fm=core;
+  iface=coreIface;
+  std::vector<unsigned char> coreState;
+  ymfm::ymfm_saved_state saver(coreState,true);
+  st->fm->save_restore(saver);
+  ymfm::ymfm_saved_state loader(coreState,false);
+  fm->save_restore(loader);
+}
+
+void* DivPlatformYM2610B::getState() {
+  DivPlatformYM2610B* st=new DivPlatformYM2610B(*this);
+  cloneCore(st);
+  return st;
+}
+
+void DivPlatformYM2610B::setState(void* state) {
+  DivPlatformYM2610B* st=(DivPlatformYM2610B*)state;
+  ymfm::ym2610b* core=fm;
+  DivYM2610Interface coreIface=iface;
+  assignState(this,st);
+  restoreCore(st,core,coreIface);
+}
+
+void DivPlatformYM2610B::freeState(void* state) {
+  DivPlatformYM2610B* st=(DivPlatformYM2610B*)state;
+  delete st->fm;
+  delete st;
+}
+
 unsigned char* DivPlatformYM2610B::getRegisterPool() {
   return regPool;
 }
@@ -1246,7 +1294,8 @@ void DivPlatformYM2610B::poke(std::vector<DivRegWrite>& wlist) {
 }
 
 void DivPlatformYM2610B::reset() {
-  while (!writes.empty()) writes.pop();
+  writes.clear();
+  writes.setSpacing(4);
   memset(regPool,0,512);
   if (dumpWrites) {
     addWrite(0xffffffff,0);
@@ -1285,7 +1334,6 @@ void DivPlatformYM2610B::reset() {
   ayEnvSlideLow=0;
   ayNoiseFreq=0;
 
-  delay=0;
 
   extMode=false;
 
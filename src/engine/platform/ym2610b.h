@@ -21,16 +21,14 @@
 #define _YM2610B_H
 #include "../dispatch.h"
 #include "../macroInt.h"
-#include <queue>
+#include "writeQueue.h"
 #include "sound/ymfm/ymfm_opn.h"
 
 #include "ym2610.h"
 
 class DivPlatformYM2610B: public DivDispatch {
   protected:
-    const unsigned short chanOffs[6]={
-      0x00, 0x01, 0x02, 0x100, 0x101, 0x102
-    };
+    static const unsigned short chanOffs[6];
 
     struct Channel {
       DivInstrumentFM state;
@@ -71,11 +69,12 @@ class DivPlatformYM2610B: public DivDispatch {
       unsigned short addr;
       unsigned char val;
       bool addrOrVal;
+      QueuedWrite(): addr(0), val(0), addrOrVal(false) {}
       QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
     };
-    std::queue<QueuedWrite> writes;
+    DivWriteQueue<QueuedWrite> writes;
     ymfm::ym2610b* fm;
-    ymfm::ym2610b::output_data fmout;
+    ymfm::ym2610b::output_data fmout[YM2610_YMFM_BATCH];
     DivYM2610Interface iface;
     unsigned char regPool[512];
     unsigned char lastBusy;
@@ -88,7 +87,6 @@ class DivPlatformYM2610B: public DivDispatch {
     int ayNoiseFreq;
     unsigned char sampleBank;
 
-    int delay;
 
     bool extMode;
   
@@ -102,12 +100,18 @@ class DivPlatformYM2610B: public DivDispatch {
     int octave(int freq);
     int toFreq(int freq);
     double NOTE_ADPCMB(int note);
+
+    void cloneCore(DivPlatformYM2610B* st);
+    void restoreCore(DivPlatformYM2610B* st, ymfm::ym2610b* core, const DivYM2610Interface& coreIface);
     friend void putDispatchChan(void*,int,int);
   
   public:
     void acquire(short* bufL, short* bufR, size_t start, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     unsigned char* getRegisterPool();
     int getRegisterPoolSize();
     void reset();
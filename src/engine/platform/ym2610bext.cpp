@@ -287,6 +287,26 @@ void* DivPlatformYM2610BExt::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformYM2610BExt::getState() {
+  DivPlatformYM2610BExt* st=new DivPlatformYM2610BExt(*this);
+  cloneCore(st);
+  return st;
+}
+
+void DivPlatformYM2610BExt::setState(void* state) {
+  DivPlatformYM2610BExt* st=(DivPlatformYM2610BExt*)state;
+  ymfm::ym2610b* core=fm;
+  DivYM2610Interface coreIface=iface;
+  assignState(this,st);
+  restoreCore(st,core,coreIface);
+}
+
+void DivPlatformYM2610BExt::freeState(void* state) {
+  DivPlatformYM2610BExt* st=(DivPlatformYM2610BExt*)state;
+  delete st->fm;
+  delete st;
+}
+
 void DivPlatformYM2610BExt::reset() {
   DivPlatformYM2610B::reset();
 
@@ -287,6 +287,26 @@ void* DivPlatformYM2610Ext::getChanState(int ch) {
   return &chan[ch];
 }
 
+void* DivPlatformYM2610Ext::getState() {
+  DivPlatformYM2610Ext* st=new DivPlatformYM2610Ext(*this);
+  cloneCore(st);
+  return st;
+}
+
+void DivPlatformYM2610Ext::setState(void* state) {
+  DivPlatformYM2610Ext* st=(DivPlatformYM2610Ext*)state;
+  ymfm::ym2610* core=fm;
+  DivYM2610Interface coreIface=iface;
+  assignState(this,st);
+  restoreCore(st,core,coreIface);
+}
+
+void DivPlatformYM2610Ext::freeState(void* state) {
+  DivPlatformYM2610Ext* st=(DivPlatformYM2610Ext*)state;
+  delete st->fm;
+  delete st;
+}
+
 void DivPlatformYM2610Ext::reset() {
   DivPlatformYM2610::reset();
 
@@ -39,6 +39,9 @@ class DivPlatformYM2610Ext: public DivPlatformYM2610 {
   public:
     int dispatch(DivCommand c);
     void* getChanState(int chan);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     void reset();
     void forceIns();
     void tick();
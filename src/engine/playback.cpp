@@ -26,9 +26,35 @@
 #include "../ta-log.h"
 #include <math.h>
 #include <sndfile.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 constexpr int MASTER_CLOCK_PREC=(sizeof(void*)==8)?8:0;
 
+static inline int lowestBit(unsigned int x) {
+#ifdef _MSC_VER
+  unsigned long ret;
+  _BitScanForward(&ret,x);
+  return ret;
+#else
+  return __builtin_ctz(x);
+#endif
+}
+
+void DivEngine::markTickChan(int ch) {
+  tickChans[ch>>5]|=1U<<(ch&31);
+}
+
+int DivEngine::nextTickChan(int ch) {
+  while (ch<DIV_MAX_CHANS) {
+    unsigned int bits=tickChans[ch>>5]>>(ch&31);
+    if (bits) return ch+lowestBit(bits);
+    ch=(ch|31)+1;
+  }
+  return -1;
+}
+
 void DivEngine::nextOrder() {
   curRow=0;
   if (repeatPattern) return;
@@ -121,7 +147,7 @@ const char* cmdName[DIV_CMD_MAX]={
 };
 
 const char* formatNote(unsigned char note, unsigned char octave) {
-  static char ret[4];
+  static thread_local char ret[4];
   if (note==100) {
     return "OFF";
   } else if (note==101) {
@@ -562,9 +588,11 @@ bool DivEngine::perSystemPostEffect(int ch, unsigned char effect, unsigned char
 }
 
 void DivEngine::processRow(int i, bool afterDelay) {
+  markTickChan(i);
   int whatOrder=afterDelay?chan[i].delayOrder:curOrder;
   int whatRow=afterDelay?chan[i].delayRow:curRow;
   DivPattern* pat=song.pat[i].getPattern(song.orders.ord[i][whatOrder],false);
+  if (whatRow<0 || whatRow>=pat->rows) return;
   // pre effects
   if (!afterDelay) for (int j=0; j<song.pat[i].effectRows; j++) {
     short effect=pat->data[whatRow][4+(j<<1)];
@@ -689,7 +717,8 @@ void DivEngine::processRow(int i, bool afterDelay) {
       case 0x0d: // next order
         if (changeOrd<0 && curOrder<(song.ordersLen-1)) {
           changeOrd=-2;
-          changePos=effectVal;
+          // jumping past the end of the pattern goes to its first row
+          changePos=(effectVal<song.patLen)?effectVal:0;
         }
         break;
       case 0x08: // panning
@@ -919,10 +948,10 @@ void DivEngine::processRow(int i, bool afterDelay) {
 }
 
 void DivEngine::nextRow() {
-  static char pb[4096];
-  static char pb1[4096];
-  static char pb2[4096];
-  static char pb3[4096];
+  static thread_local char pb[4096];
+  static thread_local char pb1[4096];
+  static thread_local char pb2[4096];
+  static thread_local char pb3[4096];
   if (view==DIV_STATUS_PATTERN) {
     strcpy(pb1,"");
     strcpy(pb3,"");
@@ -931,6 +960,7 @@ void DivEngine::nextRow() {
       strcat(pb1,pb);
       
       DivPattern* pat=song.pat[i].getPattern(song.orders.ord[i][curOrder],false);
+      if (curRow>=pat->rows) continue;
       snprintf(pb2,4095,"\x1b[37m %s",
               formatNote(pat->data[curRow][0],pat->data[curRow][1]));
       strcat(pb3,pb2);
@@ -1002,6 +1032,7 @@ void DivEngine::nextRow() {
   // post row details
   for (int i=0; i<chans; i++) {
     DivPattern* pat=song.pat[i].getPattern(song.orders.ord[i][curOrder],false);
+    if (curRow>=pat->rows) continue;
     if (!(pat->data[curRow][0]==0 && pat->data[curRow][1]==0)) {
       if (pat->data[curRow][0]!=100) {
         if (!chan[i].legato) dispatchCmd(DivCommand(DIV_CMD_PRE_NOTE,i,ticks));
@@ -1023,6 +1054,13 @@ bool DivEngine::nextTick(bool noAccum) {
     cycles++;
   }
 
+  // about to play the first row of an order
+  if (checkpointInterval>0 && checkpointTimeValid && !checkpointsOff && !freelance && stepPlay==0 && !endOfSong) {
+    if (ticks<=1 && curRow==0 && curOrder>0 && (curOrder%checkpointInterval)==0) {
+      saveCheckpoint();
+    }
+  }
+
   while (!pendingNotes.empty()) {
     DivNoteEvent& note=pendingNotes.front();
     if (note.on) {
@@ -1049,7 +1087,8 @@ bool DivEngine::nextTick(bool noAccum) {
       nextRow();
     }
     // process stuff
-    for (int i=0; i<chans; i++) {
+    // only channels which may have effects running are visited, in order
+    for (int i=nextTickChan(0); i>=0 && i<chans; i=nextTickChan(i+1)) {
       if (chan[i].rowDelay>0) {
         if (--chan[i].rowDelay==0) {
           processRow(i,true);
@@ -1151,6 +1190,12 @@ bool DivEngine::nextTick(bool noAccum) {
       } else {
         chan[i].arpYield=false;
       }
+
+      // nothing left to do until the next row which changes this channel
+      if (chan[i].rowDelay<=0 && !chan[i].retrigSpeed && chan[i].volSpeed==0 && chan[i].vibratoDepth<=0 &&
+          (!(chan[i].keyOn || chan[i].keyOff) || chan[i].portaSpeed<=0) && chan[i].cut<=0 && chan[i].arp==0) {
+        tickChans[i>>5]&=~(1U<<(i&31));
+      }
     }
   }
 
@@ -1179,6 +1224,72 @@ bool DivEngine::nextTick(bool noAccum) {
   return ret;
 }
 
+static void _acquireNext(void* dc) {
+  ((DivDispatchContainer*)dc)->acquireNext();
+}
+
+static void _fillNext(void* dc) {
+  ((DivDispatchContainer*)dc)->fillNext();
+}
+
+// chips only share read-only song data while rendering, so every system
+// can run on its own thread until the next tick.
+void DivEngine::acquireSystems() {
+  if (renderPool==NULL || song.systemLen<2) {
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].acquireNext();
+    }
+    return;
+  }
+  for (int i=0; i<song.systemLen; i++) {
+    renderPool->push(_acquireNext,&disCont[i]);
+  }
+  renderPool->wait();
+}
+
+void DivEngine::fillSystems() {
+  if (renderPool==NULL || song.systemLen<2) {
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].fillNext();
+    }
+    return;
+  }
+  for (int i=0; i<song.systemLen; i++) {
+    renderPool->push(_fillNext,&disCont[i]);
+  }
+  renderPool->wait();
+}
+
+void DivEngine::runRenderAhead() {
+  std::unique_lock<std::mutex> lock(aheadLock);
+  while (aheadRunning) {
+    if (aheadRing.space()<aheadChunk) {
+      aheadCond.wait_for(lock,std::chrono::milliseconds(2));
+      continue;
+    }
+    lock.unlock();
+    nextBuf(NULL,aheadBuf,0,2,aheadChunk);
+    aheadRing.write(aheadBuf,aheadChunk);
+    lock.lock();
+  }
+}
+
+void DivEngine::processAudio(float** in, float** out, int inChans, int outChans, unsigned int size) {
+  if (aheadThread==NULL) {
+    nextBuf(in,out,inChans,outChans,size);
+    return;
+  }
+
+  // never block here. if the render thread fell behind, output silence.
+  size_t avail=aheadRing.read(out,size);
+  if (avail<size) {
+    memset(out[0]+avail,0,(size-avail)*sizeof(float));
+    memset(out[1]+avail,0,(size-avail)*sizeof(float));
+    aheadUnderruns++;
+  }
+  aheadCond.notify_one();
+}
+
 void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size) {
   if (out!=NULL) {
     memset(out[0],0,size*sizeof(float));
@@ -1259,25 +1370,20 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
   }
 
   // logic starts here
-  size_t runtotal[32];
-  size_t runLeft[32];
-  size_t runPos[32];
-  size_t lastAvail[32];
   for (int i=0; i<song.systemLen; i++) {
-    lastAvail[i]=blip_samples_avail(disCont[i].bb[0]);
-    if (lastAvail[i]>0) {
-      disCont[i].flush(lastAvail[i]);
+    DivDispatchContainer& dc=disCont[i];
+    dc.bufSize=size;
+    dc.lastAvail=blip_samples_avail(dc.bb[0]);
+    if (dc.lastAvail>0) {
+      dc.flush(dc.lastAvail);
     }
-    runtotal[i]=blip_clocks_needed(disCont[i].bb[0],size-lastAvail[i]);
-    if (runtotal[i]>disCont[i].bbInLen) {
-      delete disCont[i].bbIn[0];
-      delete disCont[i].bbIn[1];
-      disCont[i].bbIn[0]=new short[runtotal[i]+256];
-      disCont[i].bbIn[1]=new short[runtotal[i]+256];
-      disCont[i].bbInLen=runtotal[i]+256;
+    dc.runtotal=blip_clocks_needed(dc.bb[0],size-dc.lastAvail);
+    if (dc.runtotal>dc.bbInLen) {
+      dc.resizeIn(dc.runtotal+256);
     }
-    runLeft[i]=runtotal[i];
-    runPos[i]=0;
+    dc.runLeft=dc.runtotal;
+    dc.runPos=0;
+    dc.runNext=0;
   }
 
   if (metroTickLen<size) {
@@ -1326,20 +1432,18 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
       // 3. tick the clock and fill buffers as needed
       if (cycles<runLeftG) {
         for (int i=0; i<song.systemLen; i++) {
-          int total=(cycles*runtotal[i])/(size<<MASTER_CLOCK_PREC);
-          disCont[i].acquire(runPos[i],total);
-          runLeft[i]-=total;
-          runPos[i]+=total;
+          disCont[i].runNext=(cycles*disCont[i].runtotal)/(size<<MASTER_CLOCK_PREC);
         }
+        acquireSystems();
         runLeftG-=cycles;
         cycles=0;
       } else {
         cycles-=runLeftG;
         runLeftG=0;
         for (int i=0; i<song.systemLen; i++) {
-          disCont[i].acquire(runPos[i],runLeft[i]);
-          runLeft[i]=0;
+          disCont[i].runNext=disCont[i].runLeft;
         }
+        acquireSystems();
       }
     }
   }
@@ -1358,9 +1462,7 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
   }
   totalProcessed=size-(runLeftG>>MASTER_CLOCK_PREC);
 
-  for (int i=0; i<song.systemLen; i++) {
-    disCont[i].fillBuf(runtotal[i],lastAvail[i],size-lastAvail[i]);
-  }
+  fillSystems();
 
   for (int i=0; i<song.systemLen; i++) {
     float volL=((float)song.systemVol[i]/64.0f)*((float)MIN(127,127-(int)song.systemPan[i])/127.0f)*song.masterVol;
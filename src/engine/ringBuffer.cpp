@@ -0,0 +1,89 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ringBuffer.h"
+#include <string.h>
+
+// one slot is always left empty to tell a full buffer from an empty one.
+
+size_t DivAudioRing::available() {
+  if (len==0) return 0;
+  size_t r=readPos.load(std::memory_order_acquire);
+  size_t w=writePos.load(std::memory_order_acquire);
+  return (w+len-r)%len;
+}
+
+size_t DivAudioRing::space() {
+  if (len==0) return 0;
+  return len-1-available();
+}
+
+size_t DivAudioRing::write(float** data, size_t count) {
+  size_t room=space();
+  if (count>room) count=room;
+  size_t w=writePos.load(std::memory_order_relaxed);
+  size_t first=len-w;
+  if (first>count) first=count;
+  for (int i=0; i<2; i++) {
+    memcpy(buf[i]+w,data[i],first*sizeof(float));
+    memcpy(buf[i],data[i]+first,(count-first)*sizeof(float));
+  }
+  writePos.store((w+count)%len,std::memory_order_release);
+  return count;
+}
+
+size_t DivAudioRing::read(float** data, size_t count) {
+  size_t avail=available();
+  if (count>avail) count=avail;
+  size_t r=readPos.load(std::memory_order_relaxed);
+  size_t first=len-r;
+  if (first>count) first=count;
+  for (int i=0; i<2; i++) {
+    memcpy(data[i],buf[i]+r,first*sizeof(float));
+    memcpy(data[i]+first,buf[i],(count-first)*sizeof(float));
+  }
+  readPos.store((r+count)%len,std::memory_order_release);
+  return count;
+}
+
+bool DivAudioRing::init(size_t size) {
+  quit();
+  if (size<2) return false;
+  len=size;
+  buf[0]=new float[len];
+  buf[1]=new float[len];
+  readPos=0;
+  writePos=0;
+  return true;
+}
+
+void DivAudioRing::quit() {
+  if (len==0) return;
+  delete[] buf[0];
+  delete[] buf[1];
+  buf[0]=NULL;
+  buf[1]=NULL;
+  len=0;
+  readPos=0;
+  writePos=0;
+}
+
+DivAudioRing::~DivAudioRing() {
+  quit();
+}
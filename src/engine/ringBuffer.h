@@ -0,0 +1,72 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _RINGBUFFER_H
+#define _RINGBUFFER_H
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * a lock-free stereo audio ring buffer.
+ * safe for one writer thread and one reader thread.
+ */
+class DivAudioRing {
+  float* buf[2];
+  size_t len;
+  std::atomic<size_t> readPos, writePos;
+
+  public:
+    /**
+     * get the amount of samples ready to be read.
+     */
+    size_t available();
+
+    /**
+     * get the amount of samples that can be written.
+     */
+    size_t space();
+
+    /**
+     * write samples. only call from the writer thread.
+     * @return the amount of samples written.
+     */
+    size_t write(float** data, size_t count);
+
+    /**
+     * read samples. only call from the reader thread.
+     * @return the amount of samples read.
+     */
+    size_t read(float** data, size_t count);
+
+    /**
+     * allocate the buffer.
+     * @param size the capacity in samples.
+     */
+    bool init(size_t size);
+    void quit();
+
+    DivAudioRing():
+      buf{NULL,NULL},
+      len(0),
+      readPos(0),
+      writePos(0) {}
+    ~DivAudioRing();
+};
+
+#endif
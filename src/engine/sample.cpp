@@ -20,6 +20,7 @@
 #include "sample.h"
 #include "../ta-log.h"
 #include <string.h>
+#include <mutex>
 #include <sndfile.h>
 #include <math.h>
 
@@ -31,11 +32,16 @@ extern "C" {
 #include "../../extern/adpcm/ymz_codec.h"
 }
 
+static std::mutex lazyLock;
+
 bool DivSample::save(const char* path) {
   SNDFILE* f;
   SF_INFO si;
   memset(&si,0,sizeof(SF_INFO));
 
+  // no chip needed this sample yet, so there is no 16-bit data
+  if (lazyData!=NULL) render(0);
+
   if (length16<1) return false;
 
   si.channels=1;
@@ -142,16 +148,131 @@ bool DivSample::initInternal(unsigned char d, int count) {
   return true;
 }
 
+void DivSample::freeInternal(unsigned char d) {
+  switch (d) {
+    case 0: // 1-bit
+      if (data1!=NULL) delete[] data1;
+      data1=NULL;
+      length1=0;
+      break;
+    case 1: // DPCM
+      if (dataDPCM!=NULL) delete[] dataDPCM;
+      dataDPCM=NULL;
+      lengthDPCM=0;
+      break;
+    case 4: // QSound ADPCM
+      if (dataQSoundA!=NULL) delete[] dataQSoundA;
+      dataQSoundA=NULL;
+      lengthQSoundA=0;
+      break;
+    case 5: // ADPCM-A
+      if (dataA!=NULL) delete[] dataA;
+      dataA=NULL;
+      lengthA=0;
+      break;
+    case 6: // ADPCM-B
+      if (dataB!=NULL) delete[] dataB;
+      dataB=NULL;
+      lengthB=0;
+      break;
+    case 7: // X68000 ADPCM
+      if (dataX68!=NULL) delete[] dataX68;
+      dataX68=NULL;
+      lengthX68=0;
+      break;
+    case 8: // 8-bit
+      if (data8!=NULL) delete[] data8;
+      data8=NULL;
+      length8=0;
+      break;
+    case 9: // BRR
+      if (dataBRR!=NULL) delete[] dataBRR;
+      dataBRR=NULL;
+      lengthBRR=0;
+      break;
+    case 10: // VOX
+      if (dataVOX!=NULL) delete[] dataVOX;
+      dataVOX=NULL;
+      lengthVOX=0;
+      break;
+    case 16: // 16-bit
+      if (data16!=NULL) delete[] data16;
+      data16=NULL;
+      length16=0;
+      break;
+  }
+}
+
 bool DivSample::init(unsigned int count) {
   if (!initInternal(depth,count)) return false;
   samples=count;
+  dirty=true;
   return true;
 }
 
-void DivSample::render() {
+void DivSample::loadLazy() {
+  // samples may be loaded from several render threads at once
+  lazyLock.lock();
+  if (lazyData!=NULL) {
+    if (initInternal(depth,samples)) {
+      unsigned int len=getCurBufLen();
+      if (len>lazyLen) {
+        logW("sample %s is incomplete!\n",name.c_str());
+        len=lazyLen;
+      }
+      memcpy(getCurBuf(),lazyData,len);
+    }
+    lazyData=NULL;
+    lazyLen=0;
+    dirty=true;
+  }
+  lazyLock.unlock();
+}
+
+// FNV-1a over the source format data.
+unsigned long long DivSample::getSourceHash() {
+  unsigned long long hash=0xcbf29ce484222325ULL;
+  unsigned char* buf=(unsigned char*)getCurBuf();
+  unsigned int len=getCurBufLen();
+  hash=(hash^depth)*0x100000001b3ULL;
+  for (int i=0; i<4; i++) {
+    hash=(hash^((samples>>(i*8))&0xff))*0x100000001b3ULL;
+  }
+  if (buf!=NULL) {
+    for (unsigned int i=0; i<len; i++) {
+      hash=(hash^buf[i])*0x100000001b3ULL;
+    }
+  }
+  return hash;
+}
+
+unsigned int DivSample::prepareRender(unsigned int formatMask) {
+  loadLazy();
+
+  // the source format and 16-bit are always kept
+  formatMask|=DIV_SAMPLE_FORMAT(depth)|DIV_SAMPLE_FORMAT(16);
+
+  // the data is only hashed again if it may have changed
+  if (dirty) {
+    unsigned long long hash=getSourceHash();
+    if (hash!=renderHash) {
+      renderHash=hash;
+      renderedFormats=DIV_SAMPLE_FORMAT(depth);
+    }
+    dirty=false;
+  }
+
+  // free formats nobody asked for
+  for (unsigned char i=0; i<=16; i++) {
+    if (i==depth) continue;
+    if (formatMask&DIV_SAMPLE_FORMAT(i)) continue;
+    freeInternal(i);
+    renderedFormats&=~DIV_SAMPLE_FORMAT(i);
+  }
+
   // step 1: convert to 16-bit if needed
-  if (depth!=16) {
-    if (!initInternal(16,samples)) return;
+  if (!(renderedFormats&DIV_SAMPLE_FORMAT(16))) {
+    if (!initInternal(16,samples)) return 0;
     switch (depth) {
       case 0: // 1-bit
         for (unsigned int i=0; i<samples; i++) {
@@ -192,61 +313,80 @@ void DivSample::render() {
         oki_decode(dataVOX,data16,samples);
         break;
       default:
-        return;
+        return 0;
     }
+    renderedFormats|=DIV_SAMPLE_FORMAT(16);
   }
 
+  return formatMask&(~renderedFormats);
+}
+
+bool DivSample::renderFormat(unsigned char d) {
   // step 2: render to other formats
-  if (depth!=0) { // 1-bit
-    if (!initInternal(0,samples)) return;
-    for (unsigned int i=0; i<samples; i++) {
-      if (data16[i]>0) {
-        data1[i>>3]|=1<<(i&7);
+  switch (d) {
+    case 0: // 1-bit
+      if (!initInternal(0,samples)) return false;
+      for (unsigned int i=0; i<samples; i++) {
+        if (data16[i]>0) {
+          data1[i>>3]|=1<<(i&7);
+        }
       }
-    }
-  }
-  if (depth!=1) { // DPCM
-    if (!initInternal(1,samples)) return;
-    int accum=63;
-    for (unsigned int i=0; i<samples; i++) {
-      int next=((unsigned short)(data16[i]^0x8000))>>9;
-      if (next>accum) {
-        dataDPCM[i>>3]|=1<<(i&7);
-        accum++;
-      } else {
-        accum--;
+      break;
+    case 1: { // DPCM
+      if (!initInternal(1,samples)) return false;
+      int accum=63;
+      for (unsigned int i=0; i<samples; i++) {
+        int next=((unsigned short)(data16[i]^0x8000))>>9;
+        if (next>accum) {
+          dataDPCM[i>>3]|=1<<(i&7);
+          accum++;
+        } else {
+          accum--;
+        }
+        if (accum<0) accum=0;
+        if (accum>127) accum=127;
       }
-      if (accum<0) accum=0;
-      if (accum>127) accum=127;
-    }
-  }
-  if (depth!=4) { // QSound ADPCM
-    if (!initInternal(4,samples)) return;
-    bs_encode(data16,dataQSoundA,samples);
-  }
-  // TODO: pad to 256.
-  if (depth!=5) { // ADPCM-A
-    if (!initInternal(5,samples)) return;
-    yma_encode(data16,dataA,(samples+511)&(~0x1ff));
-  }
-  if (depth!=6) { // ADPCM-B
-    if (!initInternal(6,samples)) return;
-    ymb_encode(data16,dataB,(samples+511)&(~0x1ff));
-  }
-  if (depth!=7) { // X68000 ADPCM
-    if (!initInternal(7,samples)) return;
-    oki6258_encode(data16,dataX68,samples);
-  }
-  if (depth!=8) { // 8-bit PCM
-    if (!initInternal(8,samples)) return;
-    for (unsigned int i=0; i<samples; i++) {
-      data8[i]=data16[i]>>8;
+      break;
     }
+    case 4: // QSound ADPCM
+      if (!initInternal(4,samples)) return false;
+      bs_encode(data16,dataQSoundA,samples);
+      break;
+    // TODO: pad to 256.
+    case 5: // ADPCM-A
+      if (!initInternal(5,samples)) return false;
+      yma_encode(data16,dataA,(samples+511)&(~0x1ff));
+      break;
+    case 6: // ADPCM-B
+      if (!initInternal(6,samples)) return false;
+      ymb_encode(data16,dataB,(samples+511)&(~0x1ff));
+      break;
+    case 7: // X68000 ADPCM
+      if (!initInternal(7,samples)) return false;
+      oki6258_encode(data16,dataX68,samples);
+      break;
+    case 8: // 8-bit PCM
+      if (!initInternal(8,samples)) return false;
+      for (unsigned int i=0; i<samples; i++) {
+        data8[i]=data16[i]>>8;
+      }
+      break;
+    // TODO: BRR!
+    case 10: // VOX
+      if (!initInternal(10,samples)) return false;
+      oki_encode(data16,dataVOX,samples);
+      break;
+    default:
+      return false;
   }
-  // TODO: BRR!
-  if (depth!=10) { // VOX
-    if (!initInternal(10,samples)) return;
-    oki_encode(data16,dataVOX,samples);
+  return true;
+}
+
+void DivSample::render(unsigned int formatMask) {
+  unsigned int needed=prepareRender(formatMask);
+  for (unsigned char i=0; i<16; i++) {
+    if (!(needed&DIV_SAMPLE_FORMAT(i))) continue;
+    if (renderFormat(i)) renderedFormats|=DIV_SAMPLE_FORMAT(i);
   }
 }
 
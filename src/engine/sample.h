@@ -19,6 +19,9 @@
 
 #include "../ta-utils.h"
 
+// format bit for DivSample::render(), by depth.
+#define DIV_SAMPLE_FORMAT(d) (1U<<(d))
+
 struct DivSample {
   String name;
   int rate, centerRate, loopStart, loopOffP;
@@ -53,10 +56,50 @@ struct DivSample {
 
   unsigned int samples;
 
+  // hash of the source data the other formats were rendered from,
+  // and the formats which are up to date.
+  unsigned long long renderHash;
+  unsigned int renderedFormats;
+  // set this after changing the sample data, so that the next render checks it again.
+  bool dirty;
+
+  // renderHash of the data currently packed at offA/offB/offQSound in the engine's
+  // chip memories, or 0 if it isn't there.
+  unsigned long long packedA, packedB, packedQSound;
+
+  // data which has not been read yet when the song was loaded on demand.
+  // it points into the song's copy of the file.
+  const unsigned char* lazyData;
+  size_t lazyLen;
+
   bool save(const char* path);
   bool initInternal(unsigned char d, int count);
+  void freeInternal(unsigned char d);
   bool init(unsigned int count);
-  void render();
+  unsigned long long getSourceHash();
+  /**
+   * render the sample to 16-bit and to the formats in formatMask.
+   * formats which are already rendered from the same data are kept.
+   * formats which are not in the mask are freed (except the source one).
+   * @param formatMask a combination of DIV_SAMPLE_FORMAT(depth).
+   */
+  void render(unsigned int formatMask);
+  /**
+   * first half of render(): check the data, free unused formats and convert to 16-bit.
+   * @return the formats which still have to be produced using renderFormat().
+   */
+  unsigned int prepareRender(unsigned int formatMask);
+  /**
+   * second half of render(): produce one format from the 16-bit data.
+   * different formats of the same sample may be rendered at the same time.
+   * the caller has to add the format to renderedFormats afterwards.
+   * @return whether the format was rendered.
+   */
+  bool renderFormat(unsigned char d);
+  /**
+   * read the sample data from the file if it hasn't been read yet.
+   */
+  void loadLazy();
   void* getCurBuf();
   unsigned int getCurBufLen();
   DivSample():
@@ -98,6 +141,14 @@ struct DivSample {
     offVOX(0),
     offSegaPCM(0),
     offQSound(0),
-    samples(0) {}
+    samples(0),
+    renderHash(0),
+    renderedFormats(0),
+    dirty(true),
+    packedA(0),
+    packedB(0),
+    packedQSound(0),
+    lazyData(NULL),
+    lazyLen(0) {}
   ~DivSample();
 };
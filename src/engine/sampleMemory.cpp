@@ -0,0 +1,135 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "sampleMemory.h"
+#include "../ta-utils.h"
+#include <string.h>
+#include <algorithm>
+
+static bool _entryCompare(const DivSampleMemoryEntry* a, const DivSampleMemoryEntry* b) {
+  if (a->len!=b->len) return a->len>b->len;
+  return a->index<b->index;
+}
+
+bool DivSampleMemory::place(std::vector<DivSampleMemoryEntry>& entries) {
+  std::vector<DivSampleMemoryEntry*> order;
+  order.reserve(entries.size());
+  for (DivSampleMemoryEntry& i: entries) {
+    i.offset=0;
+    i.placed=false;
+    order.push_back(&i);
+  }
+  // largest first. ties are broken by index so the layout is stable.
+  std::sort(order.begin(),order.end(),_entryCompare);
+
+  size_t maxBanks=maxLen/bankSize;
+  size_t end=0;
+  bool ret=true;
+  bankFill.clear();
+  usedLen=0;
+  for (DivSampleMemoryEntry* i: order) {
+    size_t entryLen=((i->len+align-1)/align)*align;
+    if (entryLen==0) {
+      i->placed=true;
+      continue;
+    }
+    if (entryLen>bankSize) {
+      // take whole banks. the space left in the last one may be used by others.
+      size_t count=(entryLen+bankSize-1)/bankSize;
+      if (bankFill.size()+count>maxBanks) {
+        ret=false;
+        continue;
+      }
+      i->offset=bankFill.size()*bankSize;
+      for (size_t j=1; j<count; j++) {
+        bankFill.push_back(bankSize);
+      }
+      bankFill.push_back(entryLen-(count-1)*bankSize);
+    } else {
+      // best fit: the fullest bank that still has room
+      size_t best=bankFill.size();
+      for (size_t j=0; j<bankFill.size(); j++) {
+        if (bankFill[j]+entryLen>bankSize) continue;
+        if (best>=bankFill.size() || bankFill[j]>bankFill[best]) best=j;
+      }
+      if (best>=bankFill.size()) {
+        if (bankFill.size()>=maxBanks) {
+          ret=false;
+          continue;
+        }
+        bankFill.push_back(0);
+      }
+      i->offset=best*bankSize+bankFill[best];
+      bankFill[best]+=entryLen;
+    }
+    i->placed=true;
+    usedLen+=entryLen;
+    if (i->offset+entryLen>end) end=i->offset+entryLen;
+  }
+
+  // resize storage to fit
+  size_t newLen=0;
+  if (end>0) {
+    newLen=((end+tail+granularity-1)/granularity)*granularity;
+    if (newLen>maxLen) newLen=maxLen;
+  }
+  if (newLen!=len) {
+    unsigned char* newData=NULL;
+    if (newLen>0) {
+      newData=new unsigned char[newLen];
+      if (data!=NULL) memcpy(newData,data,MIN(len,newLen));
+      if (newLen>len) memset(newData+len,0,newLen-len);
+    }
+    delete[] data;
+    data=newData;
+    len=newLen;
+  }
+  return ret;
+}
+
+void DivSampleMemory::clear() {
+  delete[] data;
+  data=NULL;
+  len=0;
+  usedLen=0;
+  bankFill.clear();
+}
+
+size_t DivSampleMemory::getBankCount() {
+  return bankFill.size();
+}
+
+size_t DivSampleMemory::getWasted() {
+  if (usedLen>len) return 0;
+  return len-usedLen;
+}
+
+float DivSampleMemory::getFragmentation() {
+  if (len==0) return 0.0f;
+  return (float)getWasted()/(float)len;
+}
+
+size_t DivSampleMemory::getMaxLen() {
+  return maxLen;
+}
+
+DivSampleMemory::~DivSampleMemory() {
+  delete[] data;
+}
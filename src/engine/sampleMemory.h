@@ -0,0 +1,112 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _SAMPLEMEMORY_H
+#define _SAMPLEMEMORY_H
+#include <stddef.h>
+#include <vector>
+
+struct DivSampleMemoryEntry {
+  // caller-defined identifier (usually the sample index).
+  int index;
+  // length in bytes, including any padding after the sample.
+  size_t len;
+  // output: where the entry was placed.
+  size_t offset;
+  // output: whether the entry could be placed.
+  bool placed;
+  DivSampleMemoryEntry(int i, size_t l):
+    index(i),
+    len(l),
+    offset(0),
+    placed(false) {}
+};
+
+/**
+ * sample memory of a chip that reads samples from banks (ADPCM-A/B, QSound).
+ * entries are packed using best-fit decreasing so that little space is lost at
+ * the end of each bank, and storage is only allocated up to the last used byte.
+ */
+class DivSampleMemory {
+  size_t maxLen, bankSize, align, tail, granularity;
+  std::vector<size_t> bankFill;
+
+  public:
+    // storage. NULL until something is placed.
+    unsigned char* data;
+    // bytes visible to the chip.
+    size_t len;
+    // bytes taken by entries (including alignment).
+    size_t usedLen;
+
+    /**
+     * place entries in memory.
+     * entries larger than a bank start at a bank boundary and take as many banks as needed.
+     * this also resizes the storage to fit, keeping the current contents.
+     * @param entries the entries. offset and placed are filled in.
+     * @return whether every entry could be placed.
+     */
+    bool place(std::vector<DivSampleMemoryEntry>& entries);
+
+    /**
+     * free the storage.
+     */
+    void clear();
+
+    /**
+     * get the number of banks in use.
+     */
+    size_t getBankCount();
+
+    /**
+     * get the number of visible bytes not taken by any entry (unused bank space and the tail).
+     */
+    size_t getWasted();
+
+    /**
+     * get the fraction of visible bytes not taken by any entry.
+     */
+    float getFragmentation();
+
+    /**
+     * get the size of the chip's address space.
+     */
+    size_t getMaxLen();
+
+    /**
+     * @param max size of the chip's address space.
+     * @param bank bank size. entries may not cross a bank boundary.
+     * @param alignment entry alignment.
+     * @param tailLen bytes past the last entry that are visible to the chip.
+     * @param gran the visible length is rounded up to a multiple of this.
+     */
+    DivSampleMemory(size_t max, size_t bank, size_t alignment, size_t tailLen, size_t gran):
+      maxLen(max),
+      bankSize(bank),
+      align(alignment),
+      tail(tailLen),
+      granularity(gran),
+      data(NULL),
+      len(0),
+      usedLen(0) {}
+    ~DivSampleMemory();
+};
+
+#endif
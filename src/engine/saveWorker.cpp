@@ -0,0 +1,161 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "saveWorker.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <zlib.h>
+#include <errno.h>
+#include <string.h>
+
+#define DIV_SAVE_CHUNK 131072
+
+static void _runSaveWorker(DivSaveWorker* worker) {
+  worker->runWorker();
+}
+
+bool DivSaveWorker::writeFile(FILE* f) {
+  unsigned char* buf=w->getFinalBuf();
+  if (!compress) {
+    while (done<total) {
+      size_t amount=MIN(total-done,DIV_SAVE_CHUNK);
+      if (fwrite(buf+done,1,amount,f)!=amount) {
+        logE("did not write entirely: %s!\n",strerror(errno));
+        error=strerror(errno);
+        return false;
+      }
+      done+=amount;
+    }
+    return true;
+  }
+
+  unsigned char zbuf[DIV_SAVE_CHUNK];
+  z_stream zl;
+  memset(&zl,0,sizeof(z_stream));
+  if (deflateInit(&zl,Z_DEFAULT_COMPRESSION)!=Z_OK) {
+    logE("zlib error!\n");
+    error="compression error";
+    return false;
+  }
+  // the input is fed in chunks so that the progress can be followed
+  int flush=Z_NO_FLUSH;
+  while (flush!=Z_FINISH) {
+    size_t amount=MIN(total-done,DIV_SAVE_CHUNK);
+    zl.avail_in=amount;
+    zl.next_in=buf+done;
+    if (done+amount>=total) flush=Z_FINISH;
+    do {
+      zl.avail_out=DIV_SAVE_CHUNK;
+      zl.next_out=zbuf;
+      if (deflate(&zl,flush)==Z_STREAM_ERROR) {
+        logE("zlib stream error!\n");
+        error="zlib stream error";
+        deflateEnd(&zl);
+        return false;
+      }
+      size_t out=DIV_SAVE_CHUNK-zl.avail_out;
+      if (out>0) {
+        if (fwrite(zbuf,1,out,f)!=out) {
+          logE("did not write entirely: %s!\n",strerror(errno));
+          error=strerror(errno);
+          deflateEnd(&zl);
+          return false;
+        }
+      }
+    } while (zl.avail_out==0);
+    done+=amount;
+  }
+  deflateEnd(&zl);
+  return true;
+}
+
+void DivSaveWorker::runWorker() {
+  String tempPath=path+".tmp";
+  FILE* f=ps_fopen(tempPath.c_str(),"wb");
+  if (f==NULL) {
+    logE("could not open %s: %s!\n",tempPath.c_str(),strerror(errno));
+    error=strerror(errno);
+    failed=true;
+  } else {
+    failed=!writeFile(f);
+    if (fclose(f)!=0 && !failed) {
+      error=strerror(errno);
+      failed=true;
+    }
+    if (!failed) {
+      if (!ps_rename(tempPath.c_str(),path.c_str())) {
+        logE("could not replace %s: %s!\n",path.c_str(),strerror(errno));
+        error=strerror(errno);
+        failed=true;
+      }
+    }
+    if (failed) ps_remove(tempPath.c_str());
+  }
+  w->finish();
+  delete w;
+  w=NULL;
+  running=false;
+}
+
+void DivSaveWorker::start(SafeWriter* writer, String p, bool comp) {
+  wait();
+  w=writer;
+  path=p;
+  compress=comp;
+  error="";
+  failed=false;
+  done=0;
+  total=w->size();
+  running=true;
+  thread=new std::thread(_runSaveWorker,this);
+}
+
+bool DivSaveWorker::isBusy() {
+  return thread!=NULL;
+}
+
+bool DivSaveWorker::isDone() {
+  return thread!=NULL && !running;
+}
+
+float DivSaveWorker::getProgress() {
+  if (total==0) return running?0.0f:1.0f;
+  return (float)done/(float)total;
+}
+
+bool DivSaveWorker::wait() {
+  if (thread==NULL) return !failed;
+  thread->join();
+  delete thread;
+  thread=NULL;
+  return !failed;
+}
+
+String DivSaveWorker::getPath() {
+  return path;
+}
+
+String DivSaveWorker::getError() {
+  return error;
+}
+
+DivSaveWorker::~DivSaveWorker() {
+  wait();
+}
@@ -0,0 +1,97 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _SAVEWORKER_H
+#define _SAVEWORKER_H
+#include "safeWriter.h"
+#include "../ta-utils.h"
+#include <thread>
+#include <atomic>
+
+/**
+ * writes a saved song to disk on a separate thread.
+ * the data is compressed while it is written to a temporary file,
+ * which replaces the destination once it is complete.
+ */
+class DivSaveWorker {
+  std::thread* thread;
+  SafeWriter* w;
+  String path;
+  String error;
+  bool compress;
+  bool failed;
+  std::atomic<bool> running;
+  std::atomic<size_t> done;
+  size_t total;
+
+  bool writeFile(FILE* f);
+
+  public:
+    void runWorker();
+
+    /**
+     * start writing a file. a save which is still running is waited for first.
+     * @param writer the data to write. it is freed afterwards.
+     * @param path the destination.
+     * @param compress whether to compress the data with zlib.
+     */
+    void start(SafeWriter* writer, String path, bool compress);
+
+    /**
+     * whether a save has been started and hasn't been waited for.
+     */
+    bool isBusy();
+
+    /**
+     * whether the save has finished, so wait() won't block.
+     */
+    bool isDone();
+
+    /**
+     * get the progress of the save.
+     * @return a value from 0 to 1.
+     */
+    float getProgress();
+
+    /**
+     * wait for the save to finish.
+     * @return whether it succeeded. if not, the error is in getError().
+     */
+    bool wait();
+
+    /**
+     * get the path of the last save.
+     */
+    String getPath();
+
+    String getError();
+
+    DivSaveWorker():
+      thread(NULL),
+      w(NULL),
+      compress(false),
+      failed(false),
+      running(false),
+      done(0),
+      total(0) {}
+    ~DivSaveWorker();
+};
+
+#endif
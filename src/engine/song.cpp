@@ -38,4 +38,17 @@ void DivSong::unload() {
   for (int i=0; i<DIV_MAX_CHANS; i++) {
     pat[i].wipePatterns();
   }
+
+  if (lazyData!=NULL) {
+    delete[] lazyData;
+    lazyData=NULL;
+    lazyLen=0;
+  }
+}
+
+void DivSong::setPatLen(int len) {
+  patLen=len;
+  for (int i=0; i<DIV_MAX_CHANS; i++) {
+    pat[i].resizePatterns(len);
+  }
 }
@@ -300,8 +300,18 @@ struct DivSong {
   DivWavetable nullWave;
   DivSample nullSample;
 
+  // copy of the file when it was loaded on demand.
+  // patterns and samples which haven't been used yet are read from here.
+  unsigned char* lazyData;
+  size_t lazyLen;
+
   void unload();
 
+  /**
+   * set the pattern length and grow every pattern to it.
+   */
+  void setPatLen(int len);
+
   DivSong():
     version(0),
     isDMF(false),
@@ -350,7 +360,9 @@ struct DivSong {
     brokenShortcutSlides(false),
     ignoreDuplicateSlides(false),
     stopPortaOnNoteOff(false),
-    continuousVibrato(false) {
+    continuousVibrato(false),
+    lazyData(NULL),
+    lazyLen(0) {
     for (int i=0; i<32; i++) {
       system[i]=DIV_SYSTEM_NULL;
       systemVol[i]=64;
@@ -360,6 +372,7 @@ struct DivSong {
     for (int i=0; i<DIV_MAX_CHANS; i++) {
       chanShow[i]=true;
       chanCollapse[i]=false;
+      pat[i].patLen=patLen;
     }
     system[0]=DIV_SYSTEM_YM2612;
     system[1]=DIV_SYSTEM_SMS;
@@ -850,6 +850,35 @@ bool DivEngine::isFMSystem(DivSystem sys) {
           sys==DIV_SYSTEM_YM2612);
 }
 
+unsigned int DivEngine::getSampleFormats(DivSystem sys) {
+  switch (sys) {
+    case DIV_SYSTEM_GENESIS:
+    case DIV_SYSTEM_GENESIS_EXT:
+    case DIV_SYSTEM_ARCADE:
+    case DIV_SYSTEM_YM2612:
+    case DIV_SYSTEM_YM2612_EXT:
+    case DIV_SYSTEM_NES:
+    case DIV_SYSTEM_NES_VRC7:
+    case DIV_SYSTEM_PCE:
+    case DIV_SYSTEM_AMIGA:
+    case DIV_SYSTEM_SEGAPCM:
+    case DIV_SYSTEM_SEGAPCM_COMPAT:
+    case DIV_SYSTEM_SWAN:
+    case DIV_SYSTEM_QSOUND:
+      return DIV_SAMPLE_FORMAT(8);
+    case DIV_SYSTEM_YM2610:
+    case DIV_SYSTEM_YM2610_EXT:
+    case DIV_SYSTEM_YM2610_FULL:
+    case DIV_SYSTEM_YM2610_FULL_EXT:
+    case DIV_SYSTEM_YM2610B:
+    case DIV_SYSTEM_YM2610B_EXT:
+      return DIV_SAMPLE_FORMAT(5)|DIV_SAMPLE_FORMAT(6);
+    default:
+      break;
+  }
+  return 0;
+}
+
 bool DivEngine::isSTDSystem(DivSystem sys) {
   return (sys!=DIV_SYSTEM_ARCADE &&
           sys!=DIV_SYSTEM_YMU759 &&
@@ -468,6 +468,8 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop) {
   isBusy.lock();
   double origRate=got.rate;
   got.rate=44100;
+  // every register write has to end up in the file.
+  checkpointsOff=true;
   // determine loop point
   int loopOrder=0;
   int loopRow=0;
@@ -960,29 +962,29 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop) {
     delete[] pcmMem;
   }
 
-  if (writeADPCM && adpcmAMemLen>0) {
+  if (writeADPCM && adpcmAMem.len>0) {
     w->writeC(0x67);
     w->writeC(0x66);
     w->writeC(0x82);
-    w->writeI(adpcmAMemLen+8);
-    w->writeI(adpcmAMemLen);
+    w->writeI(adpcmAMem.len+8);
+    w->writeI(adpcmAMem.len);
     w->writeI(0);
-    w->write(adpcmAMem,adpcmAMemLen);
+    w->write(adpcmAMem.data,adpcmAMem.len);
   }
 
-  if (writeADPCM && adpcmBMemLen>0) {
+  if (writeADPCM && adpcmBMem.len>0) {
     w->writeC(0x67);
     w->writeC(0x66);
     w->writeC(0x83);
-    w->writeI(adpcmBMemLen+8);
-    w->writeI(adpcmBMemLen);
+    w->writeI(adpcmBMem.len+8);
+    w->writeI(adpcmBMem.len);
     w->writeI(0);
-    w->write(adpcmBMem,adpcmBMemLen);
+    w->write(adpcmBMem.data,adpcmBMem.len);
   }
 
-  if (writeQSound && qsoundMemLen>0) {
+  if (writeQSound && qsoundMem.len>0) {
     // always write a whole bank
-    unsigned int blockSize=(qsoundMemLen+0xffff)&(~0xffff);
+    unsigned int blockSize=(qsoundMem.len+0xffff)&(~0xffff);
     if (blockSize > 0x1000000) {
       blockSize = 0x1000000;
     }
@@ -992,7 +994,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop) {
     w->writeI(blockSize+8);
     w->writeI(0x1000000);
     w->writeI(0);
-    w->write(qsoundMem,blockSize);
+    w->write(qsoundMem.data,blockSize);
   }
 
   // initialize streams
@@ -1196,6 +1198,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop) {
   w->writeC(0x66);
 
   got.rate=origRate;
+  checkpointsOff=false;
 
   for (int i=0; i<song.systemLen; i++) {
     disCont[i].dispatch->toggleRegisterDump(false);
@@ -0,0 +1,91 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "workPool.h"
+#include "../ta-log.h"
+
+static void _runWorker(void* pool) {
+  ((DivWorkPool*)pool)->runWorker();
+}
+
+bool DivWorkPool::runOne(std::unique_lock<std::mutex>& lock) {
+  if (tasks.empty()) return false;
+  DivWorkTask task=tasks.front();
+  tasks.pop();
+  lock.unlock();
+  task.func(task.arg);
+  lock.lock();
+  if (--pending==0) doneCond.notify_all();
+  return true;
+}
+
+void DivWorkPool::runWorker() {
+  std::unique_lock<std::mutex> lock(taskLock);
+  while (true) {
+    while (!terminate && tasks.empty()) taskCond.wait(lock);
+    if (terminate) break;
+    runOne(lock);
+  }
+}
+
+void DivWorkPool::push(DivWorkFunc func, void* arg) {
+  std::unique_lock<std::mutex> lock(taskLock);
+  tasks.push(DivWorkTask(func,arg));
+  pending++;
+  taskCond.notify_one();
+}
+
+void DivWorkPool::wait() {
+  std::unique_lock<std::mutex> lock(taskLock);
+  while (runOne(lock));
+  while (pending>0) doneCond.wait(lock);
+}
+
+int DivWorkPool::getThreadCount() {
+  return threads.size();
+}
+
+bool DivWorkPool::init(int count) {
+  if (!threads.empty()) return false;
+  if (count<1) return false;
+  terminate=false;
+  for (int i=0; i<count; i++) {
+    threads.push_back(new std::thread(_runWorker,this));
+  }
+  logD("started work pool with %d threads\n",count);
+  return true;
+}
+
+void DivWorkPool::quit() {
+  if (threads.empty()) return;
+  {
+    std::unique_lock<std::mutex> lock(taskLock);
+    terminate=true;
+    taskCond.notify_all();
+  }
+  for (std::thread* i: threads) {
+    i->join();
+    delete i;
+  }
+  threads.clear();
+}
+
+DivWorkPool::~DivWorkPool() {
+  quit();
+}
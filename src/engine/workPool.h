@@ -0,0 +1,92 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2022 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _WORKPOOL_H
+#define _WORKPOOL_H
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+
+typedef void (*DivWorkFunc)(void*);
+
+struct DivWorkTask {
+  DivWorkFunc func;
+  void* arg;
+  DivWorkTask(DivWorkFunc f, void* a):
+    func(f),
+    arg(a) {}
+};
+
+/**
+ * a fixed-size pool of worker threads.
+ * tasks are pushed in batches and then joined using wait().
+ */
+class DivWorkPool {
+  std::vector<std::thread*> threads;
+  std::queue<DivWorkTask> tasks;
+  std::mutex taskLock;
+  std::condition_variable taskCond;
+  std::condition_variable doneCond;
+  int pending;
+  bool terminate;
+
+  bool runOne(std::unique_lock<std::mutex>& lock);
+
+  public:
+    void runWorker();
+
+    /**
+     * queue a task.
+     * @param func the function to run.
+     * @param arg the argument passed to func.
+     */
+    void push(DivWorkFunc func, void* arg);
+
+    /**
+     * wait for all queued tasks to finish.
+     * the calling thread takes part in running them.
+     */
+    void wait();
+
+    /**
+     * get the number of worker threads.
+     */
+    int getThreadCount();
+
+    /**
+     * start the worker threads.
+     * @param count the number of threads.
+     * @return whether the pool was started.
+     */
+    bool init(int count);
+
+    /**
+     * stop and join the worker threads.
+     */
+    void quit();
+
+    DivWorkPool():
+      pending(0),
+      terminate(false) {}
+    ~DivWorkPool();
+};
+
+#endif
@@ -18,8 +18,15 @@
  */
 
 #include "fileutils.h"
+#include <string.h>
 #ifdef _WIN32
 #include "utfutils.h"
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 FILE* ps_fopen(const char* path, const char* mode) {
@@ -29,3 +36,119 @@ FILE* ps_fopen(const char* path, const char* mode) {
   return fopen(path,mode);
 #endif
 }
+
+bool ps_rename(const char* from, const char* to) {
+#ifdef _WIN32
+  return MoveFileExW(utf8To16(from).c_str(),utf8To16(to).c_str(),MOVEFILE_REPLACE_EXISTING)!=0;
+#else
+  return rename(from,to)==0;
+#endif
+}
+
+bool ps_remove(const char* path) {
+#ifdef _WIN32
+  return _wremove(utf8To16(path).c_str())==0;
+#else
+  return remove(path)==0;
+#endif
+}
+
+// read a file which can't be mapped (such as a pipe) until EOF.
+static bool readWhole(const char* path, PSMappedFile& file) {
+  FILE* f=ps_fopen(path,"rb");
+  if (f==NULL) return false;
+  size_t cap=0;
+  size_t len=0;
+  unsigned char* data=NULL;
+  while (true) {
+    if (len>=cap) {
+      size_t newCap=(cap==0)?65536:(cap*2);
+      unsigned char* grown=new unsigned char[newCap];
+      if (data!=NULL) {
+        memcpy(grown,data,len);
+        delete[] data;
+      }
+      data=grown;
+      cap=newCap;
+    }
+    size_t got=fread(data+len,1,cap-len,f);
+    len+=got;
+    if (got==0) break;
+  }
+  if (ferror(f)) {
+    fclose(f);
+    delete[] data;
+    return false;
+  }
+  fclose(f);
+  if (len==0) {
+    delete[] data;
+    data=NULL;
+  }
+  file.data=data;
+  file.len=len;
+  file.mapped=false;
+  return true;
+}
+
+bool ps_mmap(const char* path, PSMappedFile& file) {
+  file=PSMappedFile();
+#ifdef _WIN32
+  HANDLE f=CreateFileW(utf8To16(path).c_str(),GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+  if (f==INVALID_HANDLE_VALUE) return readWhole(path,file);
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(f,&size) || size.QuadPart<1) {
+    CloseHandle(f);
+    return readWhole(path,file);
+  }
+  HANDLE m=CreateFileMappingW(f,NULL,PAGE_READONLY,0,0,NULL);
+  if (m==NULL) {
+    CloseHandle(f);
+    return readWhole(path,file);
+  }
+  // the view stays valid after the handles are closed
+  void* view=MapViewOfFile(m,FILE_MAP_READ,0,0,0);
+  CloseHandle(m);
+  CloseHandle(f);
+  if (view==NULL) return readWhole(path,file);
+  file.data=(unsigned char*)view;
+  file.len=size.QuadPart;
+  file.mapped=true;
+  return true;
+#else
+  int fd=open(path,O_RDONLY);
+  if (fd<0) return false;
+  struct stat st;
+  if (fstat(fd,&st)<0) {
+    close(fd);
+    return false;
+  }
+  if (!S_ISREG(st.st_mode) || st.st_size<1) {
+    close(fd);
+    return readWhole(path,file);
+  }
+  void* m=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if (m==MAP_FAILED) return readWhole(path,file);
+  madvise(m,st.st_size,MADV_SEQUENTIAL);
+  file.data=(unsigned char*)m;
+  file.len=st.st_size;
+  file.mapped=true;
+  return true;
+#endif
+}
+
+void ps_munmap(PSMappedFile& file) {
+  if (file.data!=NULL) {
+    if (file.mapped) {
+#ifdef _WIN32
+      UnmapViewOfFile(file.data);
+#else
+      munmap(file.data,file.len);
+#endif
+    } else {
+      delete[] file.data;
+    }
+  }
+  file=PSMappedFile();
+}
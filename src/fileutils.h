@@ -20,7 +20,30 @@
 #ifndef _FILEUTILS_H
 #define _FILEUTILS_H
 #include <stdio.h>
+#include <stddef.h>
 
 FILE* ps_fopen(const char* path, const char* mode);
 
+// rename a file, replacing the destination if it exists.
+bool ps_rename(const char* from, const char* to);
+
+bool ps_remove(const char* path);
+
+struct PSMappedFile {
+  unsigned char* data;
+  size_t len;
+  bool mapped;
+  PSMappedFile():
+    data(NULL),
+    len(0),
+    mapped(false) {}
+};
+
+// map a file for reading. if it can't be mapped, it is read into memory instead.
+// an empty file succeeds with a length of 0. on failure errno is set.
+bool ps_mmap(const char* path, PSMappedFile& file);
+
+// release a file opened with ps_mmap().
+void ps_munmap(PSMappedFile& file);
+
 #endif
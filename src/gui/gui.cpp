@@ -51,11 +51,13 @@ extern "C" {
 #include <shlwapi.h>
 #include "../utfutils.h"
 #define LAYOUT_INI "\\layout.ini"
+#define BACKUP_FUR "\\backup.fur"
 #else
 #include <unistd.h>
 #include <pwd.h>
 #include <sys/stat.h>
 #define LAYOUT_INI "/layout.ini"
+#define BACKUP_FUR "/backup.fur"
 #endif
 
 bool Particle::update(float frameTime) {
@@ -955,6 +957,7 @@ void FurnaceGUI::drawSongInfo() {
         if (realTB<1) realTB=1;
         if (realTB>16) realTB=16;
         e->song.timeBase=realTB-1;
+        e->notifySongChange();
       }
       ImGui::TableNextColumn();
       float hl=e->song.hilightA;
@@ -972,12 +975,14 @@ void FurnaceGUI::drawSongInfo() {
       ImGui::SetNextItemWidth(avail);
       if (ImGui::InputScalar("##Speed1",ImGuiDataType_U8,&e->song.speed1,&_ONE,&_THREE)) {
         if (e->song.speed1<1) e->song.speed1=1;
+        e->notifySongChange();
         if (e->isPlaying()) play();
       }
       ImGui::TableNextColumn();
       ImGui::SetNextItemWidth(avail);
       if (ImGui::InputScalar("##Speed2",ImGuiDataType_U8,&e->song.speed2,&_ONE,&_THREE)) {
         if (e->song.speed2<1) e->song.speed2=1;
+        e->notifySongChange();
         if (e->isPlaying()) play();
       }
 
@@ -1000,7 +1005,8 @@ void FurnaceGUI::drawSongInfo() {
       if (ImGui::InputInt("##PatLength",&patLen,1,3)) {
         if (patLen<1) patLen=1;
         if (patLen>256) patLen=256;
-        e->song.patLen=patLen;
+        e->setPatLen(patLen);
+        e->notifySongChange();
       }
 
       ImGui::TableNextRow();
@@ -1013,6 +1019,7 @@ void FurnaceGUI::drawSongInfo() {
         if (ordLen<1) ordLen=1;
         if (ordLen>127) ordLen=127;
         e->song.ordersLen=ordLen;
+        e->notifySongChange();
       }
 
       ImGui::TableNextRow();
@@ -1045,6 +1052,7 @@ void FurnaceGUI::drawSongInfo() {
         if (tune<220.0f) tune=220.0f;
         if (tune>880.0f) tune=880.0f;
         e->song.tuning=tune;
+        e->notifySongChange();
       }
       ImGui::EndTable();
     }
@@ -2016,6 +2024,18 @@ void FurnaceGUI::drawNewSong() {
   }
 }
 
+void FurnaceGUI::drawSampleMemoryStats(const char* name, DivSampleMemory& mem) {
+  String usage=fmt::sprintf("%d/%dKB",(int)(mem.len/1024),(int)(mem.getMaxLen()/1024));
+  ImGui::Text("%s",name);
+  ImGui::SameLine();
+  ImGui::ProgressBar(((float)mem.len)/((float)mem.getMaxLen()),ImVec2(-FLT_MIN,0),usage.c_str());
+  if (mem.len>0) {
+    ImGui::Indent();
+    ImGui::Text("%d banks, %dKB wasted (%.1f%% fragmentation)",(int)mem.getBankCount(),(int)(mem.getWasted()/1024),mem.getFragmentation()*100.0f);
+    ImGui::Unindent();
+  }
+}
+
 void FurnaceGUI::drawStats() {
   if (nextWindow==GUI_WINDOW_STATS) {
     statsOpen=true;
@@ -2024,18 +2044,9 @@ void FurnaceGUI::drawStats() {
   }
   if (!statsOpen) return;
   if (ImGui::Begin("Statistics",&statsOpen)) {
-    String adpcmAUsage=fmt::sprintf("%d/16384KB",e->adpcmAMemLen/1024);
-    String adpcmBUsage=fmt::sprintf("%d/16384KB",e->adpcmBMemLen/1024);
-    String qsoundUsage=fmt::sprintf("%d/16384KB",e->qsoundMemLen/1024);
-    ImGui::Text("ADPCM-A");
-    ImGui::SameLine();
-    ImGui::ProgressBar(((float)e->adpcmAMemLen)/16777216.0f,ImVec2(-FLT_MIN,0),adpcmAUsage.c_str());
-    ImGui::Text("ADPCM-B");
-    ImGui::SameLine();
-    ImGui::ProgressBar(((float)e->adpcmBMemLen)/16777216.0f,ImVec2(-FLT_MIN,0),adpcmBUsage.c_str());
-    ImGui::Text("QSound");
-    ImGui::SameLine();
-    ImGui::ProgressBar(((float)e->qsoundMemLen)/16777216.0f,ImVec2(-FLT_MIN,0),qsoundUsage.c_str());
+    drawSampleMemoryStats("ADPCM-A",e->adpcmAMem);
+    drawSampleMemoryStats("ADPCM-B",e->adpcmBMem);
+    drawSampleMemoryStats("QSound",e->qsoundMem);
   }
   if (ImGui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows)) curWindow=GUI_WINDOW_STATS;
   ImGui::End();
@@ -2050,48 +2061,70 @@ void FurnaceGUI::drawCompatFlags() {
   if (!compatFlagsOpen) return;
   if (ImGui::Begin("Compatibility Flags",&compatFlagsOpen)) {
     ImGui::TextWrapped("these flags are stored in the song when saving in .fur format, and are automatically enabled when saving in .dmf format.");
-    ImGui::Checkbox("Limit slide range",&e->song.limitSlides);
+    if (ImGui::Checkbox("Limit slide range",&e->song.limitSlides)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("when enabled, slides are limited to a compatible range.\nmay cause problems with slides in negative octaves.");
     }
-    ImGui::Checkbox("Linear pitch control",&e->song.linearPitch);
+    if (ImGui::Checkbox("Linear pitch control",&e->song.linearPitch)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("linear pitch:\n- slides work in frequency/period space\n- E5xx and 04xx effects work in tonality space\nnon-linear pitch:\n- slides work in frequency/period space\n- E5xx and 04xx effects work on frequency/period space");
     }
-    ImGui::Checkbox("Proper noise layout on NES and PC Engine",&e->song.properNoiseLayout);
+    if (ImGui::Checkbox("Proper noise layout on NES and PC Engine",&e->song.properNoiseLayout)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("use a proper noise channel note mapping (0-15) instead of a rather unusual compatible one.\nunlocks all noise frequencies on PC Engine.");
     }
-    ImGui::Checkbox("Game Boy instrument duty is wave volume",&e->song.waveDutyIsVol);
+    if (ImGui::Checkbox("Game Boy instrument duty is wave volume",&e->song.waveDutyIsVol)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("if enabled, an instrument with duty macro in the wave channel will be mapped to wavetable volume.");
     }
 
-    ImGui::Checkbox("Restart macro on portamento",&e->song.resetMacroOnPorta);
+    if (ImGui::Checkbox("Restart macro on portamento",&e->song.resetMacroOnPorta)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("when enabled, a portamento effect will reset the channel's macro if used in combination with a note.");
     }
-    ImGui::Checkbox("Legacy volume slides",&e->song.legacyVolumeSlides);
+    if (ImGui::Checkbox("Legacy volume slides",&e->song.legacyVolumeSlides)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("simulate glitchy volume slide behavior by silently overflowing the volume when the slide goes below 0.");
     }
-    ImGui::Checkbox("Compatible arpeggio",&e->song.compatibleArpeggio);
+    if (ImGui::Checkbox("Compatible arpeggio",&e->song.compatibleArpeggio)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("delay arpeggio by one tick on every new note.");
     }
-    ImGui::Checkbox("Reset slides after note off",&e->song.noteOffResetsSlides);
+    if (ImGui::Checkbox("Reset slides after note off",&e->song.noteOffResetsSlides)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("when enabled, note off will reset the channel's slide effect.");
     }
-    ImGui::Checkbox("Reset portamento after reaching target",&e->song.targetResetsSlides);
+    if (ImGui::Checkbox("Reset portamento after reaching target",&e->song.targetResetsSlides)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("when enabled, the slide effect is disabled after it reaches its target.");
     }
-    ImGui::Checkbox("Ignore duplicate slide effects",&e->song.ignoreDuplicateSlides);
+    if (ImGui::Checkbox("Ignore duplicate slide effects",&e->song.ignoreDuplicateSlides)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("if this is on, only the first slide of a row in a channel will be considered.");
     }
-    ImGui::Checkbox("Continuous vibrato",&e->song.continuousVibrato);
+    if (ImGui::Checkbox("Continuous vibrato",&e->song.continuousVibrato)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("when enabled, vibrato will not be reset on a new note.");
     }
@@ -2099,18 +2132,21 @@ void FurnaceGUI::drawCompatFlags() {
     ImGui::Text("Loop modality:");
     if (ImGui::RadioButton("Reset channels",e->song.loopModality==0)) {
       e->song.loopModality=0;
+      e->notifySongChange();
     }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("select to reset channels on loop. may trigger a voltage click on every loop!");
     }
     if (ImGui::RadioButton("Soft reset channels",e->song.loopModality==1)) {
       e->song.loopModality=1;
+      e->notifySongChange();
     }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("select to turn channels off on loop.");
     }
     if (ImGui::RadioButton("Do nothing",e->song.loopModality==2)) {
       e->song.loopModality=2;
+      e->notifySongChange();
     }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("select to not reset channels on loop.");
@@ -2120,19 +2156,27 @@ void FurnaceGUI::drawCompatFlags() {
 
     ImGui::TextWrapped("the following flags are for compatibility with older Furnace versions.");
 
-    ImGui::Checkbox("Arpeggio inhibits non-porta slides",&e->song.arpNonPorta);
+    if (ImGui::Checkbox("Arpeggio inhibits non-porta slides",&e->song.arpNonPorta)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("behavior changed in 0.5.5");
     }
-    ImGui::Checkbox("Wack FM algorithm macro",&e->song.algMacroBehavior);
+    if (ImGui::Checkbox("Wack FM algorithm macro",&e->song.algMacroBehavior)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("behavior changed in 0.5.5");
     }
-    ImGui::Checkbox("Broken shortcut slides (E1xy/E2xy)",&e->song.brokenShortcutSlides);
+    if (ImGui::Checkbox("Broken shortcut slides (E1xy/E2xy)",&e->song.brokenShortcutSlides)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("behavior changed in 0.5.7");
     }
-    ImGui::Checkbox("Stop portamento on note off",&e->song.stopPortaOnNoteOff);
+    if (ImGui::Checkbox("Stop portamento on note off",&e->song.stopPortaOnNoteOff)) {
+      e->notifySongChange();
+    }
     if (ImGui::IsItemHovered()) {
       ImGui::SetTooltip("behavior changed in 0.6");
     }
@@ -2617,6 +2661,7 @@ void FurnaceGUI::makeUndo(ActionType action) {
   }
   if (doPush) {
     modified=true;
+    e->notifySongChange();
     undoHist.push_back(s);
     redoHist.clear();
     if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
@@ -2976,6 +3021,7 @@ void FurnaceGUI::doUndo() {
   UndoStep& us=undoHist.back();
   redoHist.push_back(us);
   modified=true;
+  e->notifySongChange();
 
   switch (us.type) {
     case GUI_UNDO_CHANGE_ORDER:
@@ -3013,6 +3059,7 @@ void FurnaceGUI::doRedo() {
   UndoStep& us=redoHist.back();
   undoHist.push_back(us);
   modified=true;
+  e->notifySongChange();
 
   switch (us.type) {
     case GUI_UNDO_CHANGE_ORDER:
@@ -3668,6 +3715,7 @@ void FurnaceGUI::doAction(int what) {
       int curOrder=e->getOrder();
       if (e->song.orders.ord[orderCursor][curOrder]<0x7f) {
         e->song.orders.ord[orderCursor][curOrder]++;
+        e->notifySongChange();
       }
       break;
     }
@@ -3676,6 +3724,7 @@ void FurnaceGUI::doAction(int what) {
       int curOrder=e->getOrder();
       if (e->song.orders.ord[orderCursor][curOrder]>0) {
         e->song.orders.ord[orderCursor][curOrder]--;
+        e->notifySongChange();
       }
       break;
     }
@@ -3896,6 +3945,7 @@ void FurnaceGUI::keyDown(SDL_Event& ev) {
           if (orderCursor>=0 && orderCursor<e->getTotalChannelCount()) {
             int curOrder=e->getOrder();
             e->song.orders.ord[orderCursor][curOrder]=((e->song.orders.ord[orderCursor][curOrder]<<4)|num)&0x7f;
+            e->notifySongChange();
             if (orderEditMode==2 || orderEditMode==3) {
               curNibble=!curNibble;
               if (!curNibble) {
@@ -4111,9 +4161,9 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
   //ImGui::GetIO().ConfigFlags|=ImGuiConfigFlags_NavEnableKeyboard;
 }
 
-#define FURNACE_ZLIB_COMPRESS
-
 int FurnaceGUI::save(String path, int dmfVersion) {
+  // only serializing the song happens here.
+  // it is compressed and written to disk by saveWorker.
   SafeWriter* w;
   if (dmfVersion) {
     w=e->saveDMF(dmfVersion);
@@ -4124,82 +4174,8 @@ int FurnaceGUI::save(String path, int dmfVersion) {
     lastError=e->getLastError();
     return 3;
   }
-  FILE* outFile=ps_fopen(path.c_str(),"wb");
-  if (outFile==NULL) {
-    lastError=strerror(errno);
-    w->finish();
-    return 1;
-  }
-#ifdef FURNACE_ZLIB_COMPRESS
-  unsigned char zbuf[131072];
-  int ret;
-  z_stream zl;
-  memset(&zl,0,sizeof(z_stream));
-  ret=deflateInit(&zl,Z_DEFAULT_COMPRESSION);
-  if (ret!=Z_OK) {
-    logE("zlib error!\n");
-    lastError="compression error";
-    fclose(outFile);
-    w->finish();
-    return 2;
-  }
-  zl.avail_in=w->size();
-  zl.next_in=w->getFinalBuf();
-  while (zl.avail_in>0) {
-    zl.avail_out=131072;
-    zl.next_out=zbuf;
-    if ((ret=deflate(&zl,Z_NO_FLUSH))==Z_STREAM_ERROR) {
-      logE("zlib stream error!\n");
-      lastError="zlib stream error";
-      deflateEnd(&zl);
-      fclose(outFile);
-      w->finish();
-      return 2;
-    }
-    size_t amount=131072-zl.avail_out;
-    if (amount>0) {
-      if (fwrite(zbuf,1,amount,outFile)!=amount) {
-        logE("did not write entirely: %s!\n",strerror(errno));
-        lastError=strerror(errno);
-        deflateEnd(&zl);
-        fclose(outFile);
-        w->finish();
-        return 1;
-      }
-    }
-  }
-  zl.avail_out=131072;
-  zl.next_out=zbuf;
-  if ((ret=deflate(&zl,Z_FINISH))==Z_STREAM_ERROR) {
-    logE("zlib finish stream error!\n");
-    lastError="zlib finish stream error";
-    deflateEnd(&zl);
-    fclose(outFile);
-    w->finish();
-    return 2;
-  }
-  if (131072-zl.avail_out>0) {
-    if (fwrite(zbuf,1,131072-zl.avail_out,outFile)!=(131072-zl.avail_out)) {
-      logE("did not write entirely: %s!\n",strerror(errno));
-      lastError=strerror(errno);
-      deflateEnd(&zl);
-      fclose(outFile);
-      w->finish();
-      return 1;
-    }
-  }
-  deflateEnd(&zl);
-#else
-  if (fwrite(w->getFinalBuf(),1,w->size(),outFile)!=w->size()) {
-    logE("did not write entirely: %s!\n",strerror(errno));
-    lastError=strerror(errno);
-    fclose(outFile);
-    w->finish();
-    return 1;
-  }
-#endif
-  fclose(outFile);
-  w->finish();
+  backupSaving=false;
+  saveWorker.start(w,path,true);
   curFileName=path;
   modified=false;
   if (!e->getWarnings().empty()) {
@@ -4208,56 +4184,52 @@ int FurnaceGUI::save(String path, int dmfVersion) {
   return 0;
 }
 
+void FurnaceGUI::updateSave() {
+  if (saveWorker.isDone()) {
+    if (!saveWorker.wait()) {
+      if (backupSaving) {
+        logW("could not save backup! (%s)\n",saveWorker.getError().c_str());
+      } else {
+        modified=true;
+        showError(fmt::sprintf("Error while saving file! (%s)",saveWorker.getError()));
+      }
+    }
+  }
+
+  // back up the song periodically while it has unsaved changes
+  if (settings.backupInterval<1 || !modified || saveWorker.isBusy()) return;
+  if ((SDL_GetTicks()-lastBackup)<(unsigned int)settings.backupInterval*1000) return;
+  lastBackup=SDL_GetTicks();
+
+  // saveFur() marks the song as .fur
+  bool wasDMF=e->song.isDMF;
+  unsigned short version=e->song.version;
+  SafeWriter* w=e->saveFur();
+  e->song.isDMF=wasDMF;
+  e->song.version=version;
+  if (w==NULL) return;
+  backupSaving=true;
+  saveWorker.start(w,e->getConfigPath()+String(BACKUP_FUR),true);
+}
+
 int FurnaceGUI::load(String path) {
   if (!path.empty()) {
     logI("loading module...\n");
-    FILE* f=ps_fopen(path.c_str(),"rb");
-    if (f==NULL) {
+    PSMappedFile file;
+    if (!ps_mmap(path.c_str(),file)) {
       perror("error");
       lastError=strerror(errno);
       return 1;
     }
-    if (fseek(f,0,SEEK_END)<0) {
-      perror("size error");
-      lastError=fmt::sprintf("on seek: %s",strerror(errno));
-      fclose(f);
+    if (file.len<1) {
+      printf("that file is empty!\n");
+      lastError="file is empty";
+      ps_munmap(file);
       return 1;
     }
-    ssize_t len=ftell(f);
-    if (len==(SIZE_MAX>>1)) {
-      perror("could not get file length");
-      lastError=fmt::sprintf("on pre tell: %s",strerror(errno));
-      fclose(f);
-      return 1;
-    }
-    if (len<1) {
-      if (len==0) {
-        printf("that file is empty!\n");
-        lastError="file is empty";
-      } else {
-        perror("tell error");
-        lastError=fmt::sprintf("on tell: %s",strerror(errno));
-      }
-      fclose(f);
-      return 1;
-    }
-    unsigned char* file=new unsigned char[len];
-    if (fseek(f,0,SEEK_SET)<0) {
-      perror("size error");
-      lastError=fmt::sprintf("on get size: %s",strerror(errno));
-      fclose(f);
-      delete[] file;
-      return 1;
-    }
-    if (fread(file,1,(size_t)len,f)!=(size_t)len) {
-      perror("read error");
-      lastError=fmt::sprintf("on read: %s",strerror(errno));
-      fclose(f);
-      delete[] file;
-      return 1;
-    }
-    fclose(f);
-    if (!e->load(file,(size_t)len)) {
+    bool loaded=e->loadBuffer(file.data,file.len,settings.lazyLoad);
+    ps_munmap(file);
+    if (!loaded) {
       lastError=e->getLastError();
       logE("could not open file!\n");
       return 1;
@@ -4339,6 +4311,7 @@ void FurnaceGUI::processDrags(int dragX, int dragY) {
       } else {
         MACRO_DRAG(macroDragTarget);
       }
+      e->notifySongChange();
     }
   }
   if (macroLoopDragActive) {
@@ -4348,6 +4321,7 @@ void FurnaceGUI::processDrags(int dragX, int dragY) {
       if (x>=macroLoopDragLen) x=-1;
       x+=macroDragScroll;
       *macroLoopDragTarget=x;
+      e->notifySongChange();
     }
   }
   if (waveDragActive) {
@@ -4523,6 +4497,8 @@ bool FurnaceGUI::loop() {
       }
     }
     
+    updateSave();
+
     ImGui_ImplSDLRenderer_NewFrame();
     ImGui_ImplSDL2_NewFrame(sdlWin);
     ImGui::NewFrame();
@@ -5148,6 +5124,9 @@ bool FurnaceGUI::loop() {
     if (modified) {
       ImGui::Text("| modified");
     }
+    if (saveWorker.isBusy() && !backupSaving) {
+      ImGui::Text("| saving (%d%%)",(int)(saveWorker.getProgress()*100.0f));
+    }
     ImGui::EndMainMenuBar();
 
     ImGui::DockSpaceOverViewport();
@@ -5972,6 +5951,9 @@ bool FurnaceGUI::init() {
 }
 
 bool FurnaceGUI::finish() {
+  if (!saveWorker.wait() && !backupSaving) {
+    logE("could not save file! (%s)\n",saveWorker.getError().c_str());
+  }
   ImGui::SaveIniSettingsToDisk(finalLayoutPath);
   ImGui_ImplSDLRenderer_Shutdown();
   ImGui_ImplSDL2_Shutdown();
@@ -6031,6 +6013,8 @@ FurnaceGUI::FurnaceGUI():
   displayExporting(false),
   vgmExportLoop(true),
   displayNew(false),
+  backupSaving(false),
+  lastBackup(0),
   curFileDialog(GUI_FILE_OPEN),
   warnAction(GUI_WARN_OPEN),
   scrW(1280),
@@ -6040,6 +6024,7 @@ FurnaceGUI::FurnaceGUI():
   aboutSin(0),
   aboutHue(0.0f),
   curIns(0),
+  macroEditIns(-1),
   curWave(0),
   curSample(0),
   curOctave(3),
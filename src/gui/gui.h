@@ -18,6 +18,7 @@
  */
 
 #include "../engine/engine.h"
+#include "../engine/saveWorker.h"
 #include "imgui.h"
 #include "imgui_impl_sdl.h"
 #include "imgui_impl_sdlrenderer.h"
@@ -439,6 +440,12 @@ class FurnaceGUI {
   bool displayNew;
   bool willExport[32];
 
+  // songs are written to disk by saveWorker.
+  // backupSaving is set while it is writing a backup instead of the song.
+  DivSaveWorker saveWorker;
+  bool backupSaving;
+  unsigned int lastBackup;
+
   FurnaceGUIFileDialogs curFileDialog;
   FurnaceGUIWarnings warnAction;
 
@@ -470,10 +477,15 @@ class FurnaceGUI {
     int arcadeCore;
     int ym2612Core;
     int saaCore;
+    int nesRateShift;
+    int c64Core;
+    int renderThreads;
+    int seekCheckpoints;
     int mainFont;
     int patFont;
     int audioRate;
     int audioBufSize;
+    int renderAhead;
     int patRowsBase;
     int orderRowsBase;
     int soloAction;
@@ -499,6 +511,8 @@ class FurnaceGUI {
     int guiColorsBase;
     int avoidRaisingPattern;
     int insFocusesPattern;
+    int lazyLoad;
+    int backupInterval;
     unsigned int maxUndoSteps;
     String mainFontPath;
     String patFontPath;
@@ -513,10 +527,15 @@ class FurnaceGUI {
       arcadeCore(0),
       ym2612Core(0),
       saaCore(0),
+      nesRateShift(0),
+      c64Core(0),
+      renderThreads(1),
+      seekCheckpoints(4),
       mainFont(0),
       patFont(0),
       audioRate(44100),
       audioBufSize(1024),
+      renderAhead(0),
       patRowsBase(0),
       orderRowsBase(1),
       soloAction(0),
@@ -542,6 +561,8 @@ class FurnaceGUI {
       guiColorsBase(0),
       avoidRaisingPattern(0),
       insFocusesPattern(1),
+      lazyLoad(0),
+      backupInterval(120),
       maxUndoSteps(100),
       mainFontPath(""),
       patFontPath(""),
@@ -550,7 +571,7 @@ class FurnaceGUI {
 
   char finalLayoutPath[4096];
 
-  int curIns, curWave, curSample, curOctave, oldRow, oldOrder, oldOrder1, editStep, exportLoops, soloChan, soloTimeout, orderEditMode, orderCursor;
+  int curIns, macroEditIns, curWave, curSample, curOctave, oldRow, oldOrder, oldOrder1, editStep, exportLoops, soloChan, soloTimeout, orderEditMode, orderCursor;
   int loopOrder, loopRow, loopEnd, isClipping, extraChannelButtons, patNameTarget, newSongCategory;
   bool editControlsOpen, ordersOpen, insListOpen, songInfoOpen, patternOpen, insEditOpen;
   bool waveListOpen, waveEditOpen, sampleListOpen, sampleEditOpen, aboutOpen, settingsOpen;
@@ -681,6 +702,7 @@ class FurnaceGUI {
   void drawMixer();
   void drawOsc();
   void drawVolMeter();
+  void drawSampleMemoryStats(const char* name, DivSampleMemory& mem);
   void drawStats();
   void drawCompatFlags();
   void drawPiano();
@@ -733,6 +755,7 @@ class FurnaceGUI {
 
   void openFileDialog(FurnaceGUIFileDialogs type);
   int save(String path, int dmfVersion);
+  void updateSave();
   int load(String path);
   void exportAudio(String path, DivAudioExportModes mode);
 
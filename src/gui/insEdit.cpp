@@ -579,9 +579,12 @@ void FurnaceGUI::drawFMEnv(unsigned char tl, unsigned char ar, unsigned char dr,
     ImGui::SetNextItemWidth(lenAvail); \
     if (ImGui::InputScalar("##IMacroLen_" macroName,ImGuiDataType_U8,&macroLen,&_ONE,&_THREE)) { \
       if (macroLen>127) macroLen=127; \
+      e->notifySongChange(); \
     } \
     if (macroMode!=NULL) { \
-      ImGui::Checkbox("Fixed##IMacroMode_" macroName,macroMode); \
+      if (ImGui::Checkbox("Fixed##IMacroMode_" macroName,macroMode)) { \
+        e->notifySongChange(); \
+      } \
     } \
   } \
   ImGui::TableNextColumn(); \
@@ -645,10 +648,12 @@ void FurnaceGUI::drawFMEnv(unsigned char tl, unsigned char ar, unsigned char dr,
       } else { \
         macroLoop=-1; \
       } \
+      e->notifySongChange(); \
     } \
     ImGui::SetNextItemWidth(availableWidth); \
     if (ImGui::InputText("##IMacroMML_" macroName,&mmlStr)) { \
       decodeMMLStr(mmlStr,macro,macroLen,macroLoop,macroAMin,(bitfield)?((1<<macroAMax)-1):macroAMax,macroRel); \
+      e->notifySongChange(); \
     } \
     if (!ImGui::IsItemActive()) { \
       encodeMMLStr(mmlStr,macro,macroLen,macroLoop,macroRel); \
@@ -668,6 +673,7 @@ void FurnaceGUI::drawFMEnv(unsigned char tl, unsigned char ar, unsigned char dr,
     ImGui::SetNextItemWidth(lenAvail); \
     if (ImGui::InputScalar("##IOPMacroLen_" #op macroName,ImGuiDataType_U8,&macroLen,&_ONE,&_THREE)) { \
       if (macroLen>127) macroLen=127; \
+      e->notifySongChange(); \
     } \
   } \
   ImGui::TableNextColumn(); \
@@ -727,10 +733,12 @@ void FurnaceGUI::drawFMEnv(unsigned char tl, unsigned char ar, unsigned char dr,
       } else { \
         macroLoop=-1; \
       } \
+      e->notifySongChange(); \
     } \
     ImGui::SetNextItemWidth(availableWidth); \
     if (ImGui::InputText("##IOPMacroMML_" macroName,&mmlStr)) { \
       decodeMMLStr(mmlStr,macro,macroLen,macroLoop,0,bitfield?((1<<macroHeight)-1):(macroHeight),macroRel); \
+      e->notifySongChange(); \
     } \
     if (!ImGui::IsItemActive()) { \
       encodeMMLStr(mmlStr,macro,macroLen,macroLoop,macroRel); \
@@ -775,6 +783,13 @@ void FurnaceGUI::drawInsEdit() {
     ImGui::SetNextWindowFocus();
     nextWindow=GUI_WINDOW_NOTHING;
   }
+  // only the instrument in the editor keeps its macros at full length
+  if (macroEditIns!=(insEditOpen?curIns:-1)) {
+    macroDragActive=false;
+    macroLoopDragActive=false;
+    e->shrinkInsMacros(macroEditIns);
+    macroEditIns=insEditOpen?curIns:-1;
+  }
   if (!insEditOpen) return;
   ImGui::SetNextWindowSizeConstraints(ImVec2(440.0f*dpiScale,400.0f*dpiScale),ImVec2(scrW*dpiScale,scrH*dpiScale));
   if (ImGui::Begin("Instrument Editor",&insEditOpen,settings.allowEditDocking?0:ImGuiWindowFlags_NoDocking)) {
@@ -782,6 +797,8 @@ void FurnaceGUI::drawInsEdit() {
       ImGui::Text("no instrument selected");
     } else {
       DivInstrument* ins=e->song.ins[curIns];
+      // macros are stored compactly. the editor may write anywhere in them.
+      if (!ins->std.macrosExpanded()) e->expandInsMacros(curIns);
       ImGui::InputText("Name",&ins->name);
       if (ins->type<0 || ins->type>23) ins->type=DIV_INS_FM;
       int insType=ins->type;
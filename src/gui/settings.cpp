@@ -79,6 +79,21 @@ const char* saaCores[]={
   "SAASound"
 };
 
+const char* nesRates[]={
+  "Full (cycle-exact)",
+  "1/2 of APU clock",
+  "1/4 of APU clock",
+  "1/8 of APU clock",
+  "1/16 of APU clock",
+  "1/32 of APU clock"
+};
+
+const char* c64Cores[]={
+  "reSID (cycle-exact)",
+  "reSID (interpolated)",
+  "reSID (resampled)"
+};
+
 #define SAMPLE_RATE_SELECTABLE(x) \
   if (ImGui::Selectable(#x,settings.audioRate==x)) { \
     settings.audioRate=x; \
@@ -89,6 +104,11 @@ const char* saaCores[]={
     settings.audioBufSize=x; \
   }
 
+#define RENDER_AHEAD_SELECTABLE(x) \
+  if (ImGui::Selectable(#x,settings.renderAhead==x)) { \
+    settings.renderAhead=x; \
+  }
+
 #define UI_COLOR_CONFIG(what,label) \
   ImGui::ColorEdit4(label "##CC_" #what,(float*)&uiColors[what]);
 
@@ -177,6 +197,18 @@ void FurnaceGUI::drawSettings() {
           settings.restartOnFlagChange=restartOnFlagChangeB;
         }
 
+        bool lazyLoadB=settings.lazyLoad;
+        if (ImGui::Checkbox("Load patterns and samples on demand",&lazyLoadB)) {
+          settings.lazyLoad=lazyLoadB;
+        }
+
+        ImGui::Text("Backup interval (seconds, 0 to disable)");
+        ImGui::SameLine();
+        if (ImGui::InputInt("##BackupInterval",&settings.backupInterval)) {
+          if (settings.backupInterval<0) settings.backupInterval=0;
+          if (settings.backupInterval>3600) settings.backupInterval=3600;
+        }
+
         ImGui::Text("Wrap pattern cursor horizontally:");
         if (ImGui::RadioButton("No##wrapH0",settings.wrapHorizontal==0)) {
           settings.wrapHorizontal=0;
@@ -257,6 +289,23 @@ void FurnaceGUI::drawSettings() {
           ImGui::EndCombo();
         }
         
+        ImGui::Text("Render ahead");
+        ImGui::SameLine();
+        String ra=(settings.renderAhead>0)?fmt::sprintf("%d (latency: +%.1fms)",settings.renderAhead,1000.0*(double)settings.renderAhead/(double)MAX(1,settings.audioRate)):String("Off");
+        if (ImGui::BeginCombo("##RenderAhead",ra.c_str())) {
+          if (ImGui::Selectable("Off",settings.renderAhead==0)) {
+            settings.renderAhead=0;
+          }
+          RENDER_AHEAD_SELECTABLE(1024);
+          RENDER_AHEAD_SELECTABLE(2048);
+          RENDER_AHEAD_SELECTABLE(4096);
+          RENDER_AHEAD_SELECTABLE(8192);
+          ImGui::EndCombo();
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip("Renders audio on a separate thread ahead of the audio callback.\nPrevents dropouts on loaded machines at the cost of extra latency.");
+        }
+
         ImGui::Text("Quality");
         ImGui::SameLine();
         ImGui::Combo("##Quality",&settings.audioQuality,audioQualities,2);
@@ -287,6 +336,40 @@ void FurnaceGUI::drawSettings() {
         ImGui::SameLine();
         ImGui::Combo("##SAACore",&settings.saaCore,saaCores,2);
 
+        ImGui::Text("NES output rate");
+        ImGui::SameLine();
+        ImGui::Combo("##NESRate",&settings.nesRateShift,nesRates,6);
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip("Lower rates average the APU output over several cycles.\nThey are faster, but high frequencies may lose some accuracy.");
+        }
+
+        ImGui::Text("C64/SID core");
+        ImGui::SameLine();
+        ImGui::Combo("##C64Core",&settings.c64Core,c64Cores,3);
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip("Interpolated and resampled run reSID at a lower output rate, which is much faster.\nResampled filters properly and sounds closer to cycle-exact, but costs more than interpolated.");
+        }
+
+        ImGui::Text("Render threads");
+        ImGui::SameLine();
+        if (ImGui::InputInt("##RenderThreads",&settings.renderThreads)) {
+          if (settings.renderThreads<1) settings.renderThreads=1;
+          if (settings.renderThreads>32) settings.renderThreads=32;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip("Renders each chip on its own thread.\nUseful for songs with several chips at low buffer sizes.");
+        }
+
+        ImGui::Text("Seek checkpoint every");
+        ImGui::SameLine();
+        if (ImGui::InputInt("orders##SeekCheckpoints",&settings.seekCheckpoints)) {
+          if (settings.seekCheckpoints<0) settings.seekCheckpoints=0;
+          if (settings.seekCheckpoints>128) settings.seekCheckpoints=128;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip("Saves the playback state every few orders, so jumping to an order does not replay the song from the start.\nSet to 0 to disable.");
+        }
+
         ImGui::EndTabItem();
       }
       if (ImGui::BeginTabItem("Appearance")) {
@@ -851,9 +934,14 @@ void FurnaceGUI::syncSettings() {
   settings.audioQuality=e->getConfInt("audioQuality",0);
   settings.audioBufSize=e->getConfInt("audioBufSize",1024);
   settings.audioRate=e->getConfInt("audioRate",44100);
+  settings.renderAhead=e->getConfInt("renderAhead",0);
   settings.arcadeCore=e->getConfInt("arcadeCore",0);
   settings.ym2612Core=e->getConfInt("ym2612Core",0);
   settings.saaCore=e->getConfInt("saaCore",0);
+  settings.nesRateShift=e->getConfInt("nesRateShift",0);
+  settings.c64Core=e->getConfInt("c64Core",0);
+  settings.renderThreads=e->getConfInt("renderThreads",1);
+  settings.seekCheckpoints=e->getConfInt("seekCheckpoints",4);
   settings.mainFont=e->getConfInt("mainFont",0);
   settings.patFont=e->getConfInt("patFont",0);
   settings.mainFontPath=e->getConfString("mainFontPath","");
@@ -883,6 +971,8 @@ void FurnaceGUI::syncSettings() {
   settings.guiColorsBase=e->getConfInt("guiColorsBase",0);
   settings.avoidRaisingPattern=e->getConfInt("avoidRaisingPattern",0);
   settings.insFocusesPattern=e->getConfInt("insFocusesPattern",1);
+  settings.lazyLoad=e->getConfInt("lazyLoad",0);
+  settings.backupInterval=e->getConfInt("backupInterval",120);
 
   clampSetting(settings.mainFontSize,2,96);
   clampSetting(settings.patFontSize,2,96);
@@ -891,9 +981,14 @@ void FurnaceGUI::syncSettings() {
   clampSetting(settings.audioQuality,0,1);
   clampSetting(settings.audioBufSize,32,4096);
   clampSetting(settings.audioRate,8000,384000);
+  clampSetting(settings.renderAhead,0,65536);
   clampSetting(settings.arcadeCore,0,1);
   clampSetting(settings.ym2612Core,0,1);
   clampSetting(settings.saaCore,0,1);
+  clampSetting(settings.nesRateShift,0,5);
+  clampSetting(settings.c64Core,0,2);
+  clampSetting(settings.renderThreads,1,32);
+  clampSetting(settings.seekCheckpoints,0,128);
   clampSetting(settings.mainFont,0,6);
   clampSetting(settings.patFont,0,6);
   clampSetting(settings.patRowsBase,0,1);
@@ -920,6 +1015,8 @@ void FurnaceGUI::syncSettings() {
   clampSetting(settings.guiColorsBase,0,1);
   clampSetting(settings.avoidRaisingPattern,0,1);
   clampSetting(settings.insFocusesPattern,0,1);
+  clampSetting(settings.lazyLoad,0,1);
+  clampSetting(settings.backupInterval,0,3600);
 
   // keybinds
   LOAD_KEYBIND(GUI_ACTION_OPEN,FURKMOD_CMD|SDLK_o);
@@ -1086,9 +1183,14 @@ void FurnaceGUI::commitSettings() {
   e->setConf("audioQuality",settings.audioQuality);
   e->setConf("audioBufSize",settings.audioBufSize);
   e->setConf("audioRate",settings.audioRate);
+  e->setConf("renderAhead",settings.renderAhead);
   e->setConf("arcadeCore",settings.arcadeCore);
   e->setConf("ym2612Core",settings.ym2612Core);
   e->setConf("saaCore",settings.saaCore);
+  e->setConf("nesRateShift",settings.nesRateShift);
+  e->setConf("c64Core",settings.c64Core);
+  e->setConf("renderThreads",settings.renderThreads);
+  e->setConf("seekCheckpoints",settings.seekCheckpoints);
   e->setConf("mainFont",settings.mainFont);
   e->setConf("patFont",settings.patFont);
   e->setConf("mainFontPath",settings.mainFontPath);
@@ -1118,6 +1220,8 @@ void FurnaceGUI::commitSettings() {
   e->setConf("guiColorsBase",settings.guiColorsBase);
   e->setConf("avoidRaisingPattern",settings.avoidRaisingPattern);
   e->setConf("insFocusesPattern",settings.insFocusesPattern);
+  e->setConf("lazyLoad",settings.lazyLoad);
+  e->setConf("backupInterval",settings.backupInterval);
 
   PUT_UI_COLOR(GUI_COLOR_BACKGROUND);
   PUT_UI_COLOR(GUI_COLOR_FRAME_BACKGROUND);
@@ -25,7 +25,9 @@
 #endif
 #include "ta-log.h"
 #include "fileutils.h"
+#include "batch.h"
 #include "engine/engine.h"
+#include <thread>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -47,6 +49,8 @@ FurnaceGUI g;
 
 String outName;
 String vgmOutName;
+String batchPath;
+int batchJobs=0;
 int loops=1;
 DivAudioExportModes outMode=DIV_EXPORT_MODE_ONE;
 
@@ -211,6 +215,21 @@ bool pVGMOut(String val) {
   return true;
 }
 
+bool pBatch(String val) {
+  batchPath=val;
+  return true;
+}
+
+bool pJobs(String val) {
+  try {
+    batchJobs=std::stoi(val);
+  } catch (std::exception& e) {
+    logE("job count shall be a number.\n");
+    return false;
+  }
+  return true;
+}
+
 bool needsValue(String param) {
   for (size_t i=0; i<params.size(); i++) {
     if (params[i].name==param) {
@@ -226,6 +245,8 @@ void initParams() {
   params.push_back(TAParam("a","audio",true,pAudio,"jack|sdl","set audio engine (SDL by default)"));
   params.push_back(TAParam("o","output",true,pOutput,"<filename>","output audio to file"));
   params.push_back(TAParam("O","vgmout",true,pVGMOut,"<filename>","output .vgm data"));
+  params.push_back(TAParam("B","batch",true,pBatch,"<dir|list>","render every module in a directory (or in a list file) to audio files. -output sets the output directory"));
+  params.push_back(TAParam("j","jobs",true,pJobs,"<count>","set number of modules to render at once in batch mode (all cores by default)"));
   params.push_back(TAParam("L","loglevel",true,pLogLevel,"debug|info|warning|error","set the log level (info by default)"));
   params.push_back(TAParam("v","view",true,pView,"pattern|commands|nothing","set visualization (pattern by default)"));
   params.push_back(TAParam("c","console",false,pConsole,"","enable console mode"));
@@ -304,6 +325,16 @@ int main(int argc, char** argv) {
   }
 #endif
 
+  if (!batchPath.empty()) {
+    std::vector<String> files;
+    if (!batchCollect(batchPath,files)) {
+      return 1;
+    }
+    if (batchJobs<1) batchJobs=std::thread::hardware_concurrency();
+    if (batchJobs<1) batchJobs=1;
+    return batchRender(files,outName,batchJobs,loops,outMode);
+  }
+
   if (fileName.empty() && consoleMode) {
     logI("usage: %s file\n",argv[0]);
     return 1;
@@ -311,46 +342,19 @@ int main(int argc, char** argv) {
   logI("Furnace version " DIV_VERSION ".\n");
   if (!fileName.empty()) {
     logI("loading module...\n");
-    FILE* f=ps_fopen(fileName.c_str(),"rb");
-    if (f==NULL) {
+    PSMappedFile file;
+    if (!ps_mmap(fileName.c_str(),file)) {
       perror("error");
       return 1;
     }
-    if (fseek(f,0,SEEK_END)<0) {
-      perror("size error");
-      fclose(f);
-      return 1;
-    }
-    ssize_t len=ftell(f);
-    if (len==(SIZE_MAX>>1)) {
-      perror("could not get file length");
-      fclose(f);
-      return 1;
-    }
-    if (len<1) {
-      if (len==0) {
-        printf("that file is empty!\n");
-      } else {
-        perror("tell error");
-      }
-      fclose(f);
-      return 1;
-    }
-    unsigned char* file=new unsigned char[len];
-    if (fseek(f,0,SEEK_SET)<0) {
-      perror("size error");
-      fclose(f);
-      delete[] file;
-      return 1;
-    }
-    if (fread(file,1,(size_t)len,f)!=(size_t)len) {
-      perror("read error");
-      fclose(f);
-      delete[] file;
+    if (file.len<1) {
+      printf("that file is empty!\n");
+      ps_munmap(file);
       return 1;
     }
-    fclose(f);
-    if (!e.load(file,(size_t)len)) {
+    bool loaded=e.loadBuffer(file.data,file.len);
+    ps_munmap(file);
+    if (!loaded) {
       logE("could not open file!\n");
       return 1;
     }